@@ -0,0 +1,160 @@
+#include <cerrno>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "bufsd/datagram_batch.h"
+
+// Checks that datagram batches survive a loopback round trip, then compares their throughput with one sendto/recv
+// call per datagram.
+// Usage: datagram_batch_benchmark [datagram_count] [datagram_size]
+
+static const size_t BATCH_SIZE = 32;
+
+static int make_udp_socket(sockaddr_in &address)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        throw std::runtime_error(std::string("Could not create a UDP socket: ") + std::strerror(errno));
+
+    int buffer_size = 4 * 1024 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    socklen_t length = sizeof(address);
+    if (::bind(fd, (sockaddr *)&address, sizeof(address)) != 0 || ::getsockname(fd, (sockaddr *)&address, &length) != 0)
+        throw std::runtime_error(std::string("Could not bind a UDP socket: ") + std::strerror(errno));
+
+    return fd;
+}
+
+static void report(const char *path, size_t datagram_count, size_t datagram_size, std::chrono::steady_clock::duration elapsed)
+{
+    double seconds = std::chrono::duration<double>(elapsed).count();
+
+    std::cout << path << ": " << datagram_count << " datagrams of " << datagram_size << " bytes in " << seconds * 1000 << " ms ("
+              << datagram_count / seconds / 1e6 << " M datagrams/s)" << std::endl;
+}
+
+// Every datagram starts with its number, so losses and reordering show up as a mismatch
+static bool check_loopback(int sender_fd, int receiver_fd, const sockaddr_in &destination, size_t datagram_size)
+{
+    bufsd::Datagram_Batch_Sender sender(sender_fd, BATCH_SIZE);
+    bufsd::Datagram_Batch_Receiver receiver(receiver_fd, BATCH_SIZE, datagram_size);
+
+    for (unsigned int i = 0; i < BATCH_SIZE; i++)
+        sender.next_slot().push_32_big_endian(i).push_buffer(std::vector<unsigned char>(datagram_size - 4, (unsigned char)i));
+
+    if (sender.send((const sockaddr *)&destination, sizeof(destination)) != BATCH_SIZE)
+        return false;
+
+    unsigned int expected = 0;
+
+    while (expected < BATCH_SIZE)
+    {
+        size_t count = receiver.receive();
+
+        for (size_t i = 0; i < count; i++, expected++)
+        {
+            bufsd::Deserializer datagram = receiver.get_datagram(i);
+
+            if (receiver.is_truncated(i) || datagram.get_remaining() != datagram_size || datagram.get_32_big_endian() != expected)
+                return false;
+
+            if (datagram.get_byte() != (unsigned char)expected)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void benchmark_batches(int sender_fd, int receiver_fd, const sockaddr_in &destination, size_t datagram_count, size_t datagram_size)
+{
+    bufsd::Datagram_Batch_Sender sender(sender_fd, BATCH_SIZE);
+    bufsd::Datagram_Batch_Receiver receiver(receiver_fd, BATCH_SIZE, datagram_size);
+    std::vector<unsigned char> payload(datagram_size - 4, 0xab);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Each batch is drained before the next one is sent, so the receive buffer never overflows
+    for (size_t done = 0; done < datagram_count;)
+    {
+        size_t batch = std::min(BATCH_SIZE, datagram_count - done);
+
+        for (size_t i = 0; i < batch; i++)
+            sender.next_slot().push_32_big_endian((unsigned int)(done + i)).push_buffer(payload);
+        sender.send((const sockaddr *)&destination, sizeof(destination));
+
+        for (size_t received = 0; received < batch;)
+            received += receiver.receive();
+
+        done += batch;
+    }
+
+    report("sendmmsg/recvmmsg batches", datagram_count, datagram_size, std::chrono::steady_clock::now() - start);
+}
+
+static void benchmark_single(int sender_fd, int receiver_fd, const sockaddr_in &destination, size_t datagram_count, size_t datagram_size)
+{
+    std::vector<unsigned char> datagram(datagram_size, 0xab);
+    std::vector<unsigned char> incoming(datagram_size);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t done = 0; done < datagram_count;)
+    {
+        size_t batch = std::min(BATCH_SIZE, datagram_count - done);
+
+        for (size_t i = 0; i < batch; i++)
+            ::sendto(sender_fd, datagram.data(), datagram.size(), 0, (const sockaddr *)&destination, sizeof(destination));
+
+        for (size_t i = 0; i < batch; i++)
+            ::recv(receiver_fd, incoming.data(), incoming.size(), 0);
+
+        done += batch;
+    }
+
+    report("sendto/recv per datagram", datagram_count, datagram_size, std::chrono::steady_clock::now() - start);
+}
+
+int main(int argc, char **argv)
+{
+    size_t datagram_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t datagram_size = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+
+    if (datagram_size < 5 || datagram_size > 65507)
+    {
+        std::cerr << "Datagrams must have between 5 and 65507 bytes" << std::endl;
+        return 1;
+    }
+
+    sockaddr_in sender_address, receiver_address;
+    int sender_fd = make_udp_socket(sender_address);
+    int receiver_fd = make_udp_socket(receiver_address);
+
+    if (!check_loopback(sender_fd, receiver_fd, receiver_address, datagram_size))
+    {
+        std::cerr << "Loopback check failed: datagrams were lost, reordered or corrupted" << std::endl;
+        return 1;
+    }
+    std::cout << "Loopback check passed" << std::endl;
+
+    benchmark_batches(sender_fd, receiver_fd, receiver_address, datagram_count, datagram_size);
+    benchmark_single(sender_fd, receiver_fd, receiver_address, datagram_count, datagram_size);
+
+    ::close(sender_fd);
+    ::close(receiver_fd);
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bufsd/delta.h"
+
+// Round-trips deltas between small edited buffers and checks that a small edit gives a delta smaller than the target.
+// Exits with 1 if any check fails.
+
+static std::vector<unsigned char> make_base(size_t size, unsigned int seed = 12345)
+{
+    std::vector<unsigned char> base(size);
+    unsigned int state = seed;
+
+    for (unsigned char &byte : base)
+    {
+        state = state * 1103515245 + 12345;
+        byte = (unsigned char)(state >> 16);
+    }
+
+    return base;
+}
+
+static bool check(const std::string &name, const std::vector<unsigned char> &base, const std::vector<unsigned char> &target, bool small_edit)
+{
+    std::vector<unsigned char> delta = bufsd::make_delta(base, target);
+
+    if (bufsd::apply_delta(base, delta) != target)
+    {
+        std::cerr << name << ": round trip doesn't rebuild the target" << std::endl;
+        return false;
+    }
+
+    if (small_edit && delta.size() > target.size())
+    {
+        std::cerr << name << ": " << delta.size() << " bytes delta for a " << target.size() << " bytes target" << std::endl;
+        return false;
+    }
+
+    std::cout << name << ": " << target.size() << " bytes target, " << delta.size() << " bytes delta" << std::endl;
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+
+    for (size_t size : {0, 1, 31, 32, 33, 256, 4096})
+    {
+        std::vector<unsigned char> base = make_base(size);
+        const std::string suffix = " (" + std::to_string(size) + " bytes base)";
+
+        std::vector<unsigned char> prepended(base);
+        prepended.insert(prepended.begin(), 0xee);
+        ok &= check("insert at start" + suffix, base, prepended, size >= 256);
+
+        std::vector<unsigned char> inserted(base);
+        inserted.insert(inserted.begin() + size / 2, {0xee, 0xdd, 0xcc});
+        ok &= check("insert in the middle" + suffix, base, inserted, size >= 256);
+
+        std::vector<unsigned char> appended(base);
+        appended.push_back(0xee);
+        ok &= check("append" + suffix, base, appended, size >= 256);
+
+        std::vector<unsigned char> removed(base);
+        if (!removed.empty())
+            removed.erase(removed.begin());
+        ok &= check("remove first byte" + suffix, base, removed, size >= 256);
+
+        ok &= check("unrelated target" + suffix, base, make_base(size + 7, 54321), false);
+    }
+
+    if (!ok)
+        return 1;
+
+    std::cout << "Every delta check passed" << std::endl;
+}
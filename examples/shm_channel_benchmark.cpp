@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bufsd/shm_channel.h"
+#include "bufsd/unix_socket.h"
+
+// Sends the same frames from a parent producer to a forked consumer, once through a shared-memory channel and once
+// through a Unix-domain socket pair, and reports the throughput of each path.
+// Usage: shm_channel_benchmark [frame_count] [frame_size]
+
+static const char *CHANNEL_NAME = "/bufsd-benchmark";
+static const size_t SOCKET_BATCH = 64;
+
+static void report(const char *path, size_t frame_count, size_t frame_size, std::chrono::steady_clock::duration elapsed)
+{
+    double seconds = std::chrono::duration<double>(elapsed).count();
+
+    std::cout << path << ": " << frame_count << " frames of " << frame_size << " bytes in " << seconds * 1000 << " ms ("
+              << frame_count / seconds / 1e6 << " M frames/s, " << frame_count * frame_size / seconds / (1 << 20) << " MiB/s)" << std::endl;
+}
+
+// Both consumers sum the first byte of every frame and exit with it, so the frames are actually read
+static int wait_consumer(pid_t consumer)
+{
+    int status = 0;
+    ::waitpid(consumer, &status, 0);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void benchmark_shm(size_t frame_count, size_t frame_size)
+{
+    bufsd::unlink_shm_channel(CHANNEL_NAME);
+    bufsd::Shm_Channel_Writer writer(CHANNEL_NAME, 4 * 1024 * 1024);
+
+    pid_t consumer = ::fork();
+    if (consumer == 0)
+    {
+        bufsd::Shm_Channel_Reader reader(CHANNEL_NAME);
+        bufsd::Deserializer frame(nullptr, 0);
+        unsigned char checksum = 0;
+
+        // An empty frame marks the end of the run
+        while (reader.next(frame) && frame.get_remaining() > 0)
+            checksum += frame.get_byte();
+
+        reader.release();
+        ::_exit(checksum);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < frame_count; i++)
+    {
+        unsigned char *slot = writer.reserve(frame_size);
+        std::memset(slot, (int)(i & 0xff), frame_size);
+        writer.commit(frame_size);
+    }
+    writer.reserve(0);
+    writer.commit(0);
+
+    int checksum = wait_consumer(consumer);
+    report("shared memory", frame_count, frame_size, std::chrono::steady_clock::now() - start);
+
+    std::cout << "  consumer checksum " << checksum << std::endl;
+    bufsd::unlink_shm_channel(CHANNEL_NAME);
+}
+
+static void benchmark_socket(size_t frame_count, size_t frame_size)
+{
+    auto [producer_fd, consumer_fd] = bufsd::make_unix_socket_pair();
+
+    pid_t consumer = ::fork();
+    if (consumer == 0)
+    {
+        ::close(producer_fd);
+
+        bufsd::Unix_Frame_Receiver receiver(consumer_fd);
+        unsigned char checksum = 0;
+
+        while (!receiver.is_closed())
+            receiver.poll([&checksum](bufsd::Deserializer &frame) { checksum += frame.get_byte(); });
+
+        ::_exit(checksum);
+    }
+
+    ::close(consumer_fd);
+
+    // Every frame of a batch needs its own bytes, since the sender only keeps pointers until flush()
+    std::vector<std::vector<unsigned char>> batch(SOCKET_BATCH, std::vector<unsigned char>(frame_size));
+    bufsd::Unix_Frame_Sender sender(producer_fd);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < frame_count; i++)
+    {
+        std::vector<unsigned char> &frame = batch[i % SOCKET_BATCH];
+        std::memset(frame.data(), (int)(i & 0xff), frame_size);
+        sender.queue(frame.data(), frame_size);
+
+        if (i % SOCKET_BATCH == SOCKET_BATCH - 1 || i + 1 == frame_count)
+            sender.flush();
+    }
+    ::close(producer_fd);
+
+    int checksum = wait_consumer(consumer);
+    report("unix socket", frame_count, frame_size, std::chrono::steady_clock::now() - start);
+
+    std::cout << "  consumer checksum " << checksum << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t frame_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t frame_size = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 128;
+
+    if (frame_size == 0)
+    {
+        std::cerr << "Frames need at least one byte" << std::endl;
+        return 1;
+    }
+
+    benchmark_shm(frame_count, frame_size);
+    benchmark_socket(frame_count, frame_size);
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "bufsd/framing.h"
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	enum class Async_Backend
+	{
+		AUTO,
+		IO_URING,
+		THREAD_POOL
+	};
+
+	struct Async_File_Options
+	{
+		/// <summary>
+		/// AUTO uses io_uring when the kernel allows it and falls back to the thread pool otherwise.
+		/// </summary>
+		Async_Backend backend = Async_Backend::AUTO;
+
+		/// <summary>
+		/// Size of each buffer submitted to the kernel.
+		/// </summary>
+		size_t chunk_size = 1024 * 1024;
+
+		/// <summary>
+		/// Amount of chunks that can be in flight at once.
+		/// </summary>
+		unsigned int queue_depth = 4;
+
+		/// <summary>
+		/// Amount of threads of the fallback backend.
+		/// </summary>
+		unsigned int worker_count = 2;
+	};
+
+	class Async_Io_Backend;
+
+	class Async_File_Sink
+	{
+	public:
+		/// <summary>
+		/// Creates (or truncates) <paramref name="path"/> and writes to it asynchronously, so the encoding thread only blocks when every chunk is in flight (POSIX only, io_uring on Linux).
+		/// </summary>
+		/// <param name="path">Path of the file</param>
+		/// <param name="options">Backend, chunk size and queue depth</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be opened or the requested backend isn't available</exception>
+		Async_File_Sink(const std::string &path, const Async_File_Options &options = {});
+		~Async_File_Sink();
+
+		Async_File_Sink(const Async_File_Sink &) = delete;
+		Async_File_Sink &operator=(const Async_File_Sink &) = delete;
+
+		/// <summary>
+		/// Copies bytes into the current chunk, submitting the chunk as soon as it is full.
+		/// </summary>
+		/// <param name="data">Pointer to the first byte</param>
+		/// <param name="size">Amount of bytes</param>
+		/// <exception cref="runtime_error">Occurs if a previous write failed</exception>
+		/// <returns>Reference to the sink object (allows chaining methods)</returns>
+		Async_File_Sink &write(const unsigned char *data, size_t size);
+
+		/// <summary>
+		/// Copies the buffer of <paramref name="serializer"/> into the current chunk.
+		/// </summary>
+		/// <param name="serializer">Serializer holding the bytes</param>
+		/// <exception cref="runtime_error">Occurs if a previous write failed</exception>
+		/// <returns>Reference to the sink object (allows chaining methods)</returns>
+		Async_File_Sink &write(Serializer &serializer);
+
+		/// <summary>
+		/// Writes <paramref name="serializer"/> as a frame preceded by its length prefix.
+		/// </summary>
+		/// <param name="serializer">Serializer holding the frame</param>
+		/// <param name="prefix">Format of the length prefix</param>
+		/// <exception cref="runtime_error">Occurs if the frame doesn't fit in the prefix or a previous write failed</exception>
+		/// <returns>Reference to the sink object (allows chaining methods)</returns>
+		Async_File_Sink &write_frame(Serializer &serializer, const Length_Prefix &prefix = {});
+
+		/// <summary>
+		/// Submits the partially filled chunk and waits until every write completed.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if a write failed</exception>
+		void flush();
+
+		/// <summary>
+		/// Flushes and closes the file. Called by the destructor, which ignores errors.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if a write failed</exception>
+		void close();
+
+		/// <summary>
+		/// Get the amount of bytes written so far, including the ones still in flight.
+		/// </summary>
+		/// <returns>Size of the file once flushed</returns>
+		unsigned long long get_size() const;
+
+		/// <summary>
+		/// Get the backend actually used.
+		/// </summary>
+		/// <returns>IO_URING or THREAD_POOL</returns>
+		Async_Backend get_backend() const;
+
+	private:
+		struct Chunk
+		{
+			std::unique_ptr<unsigned char[]> data;
+			size_t size = 0;
+			size_t done = 0;
+			unsigned long long offset = 0;
+			bool in_flight = false;
+		};
+
+		int fd = -1;
+		size_t chunk_size;
+		std::unique_ptr<Async_Io_Backend> backend;
+		std::vector<Chunk> chunks;
+
+		size_t current = 0;
+		bool has_current = false;
+		unsigned long long offset = 0;
+		size_t in_flight = 0;
+
+		void submit(size_t chunk);
+		void wait_one();
+	};
+
+	class Async_File_Source
+	{
+	public:
+		/// <summary>
+		/// Opens <paramref name="path"/> and starts prefetching its first chunks asynchronously (POSIX only, io_uring on Linux).
+		/// </summary>
+		/// <param name="path">Path of the file</param>
+		/// <param name="options">Backend, chunk size and queue depth (how many chunks are read ahead)</param>
+		/// <param name="prefix">Format of the length prefix used by next()</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be opened, the requested backend isn't available or the prefix width is not between 1 and 8</exception>
+		Async_File_Source(const std::string &path, const Async_File_Options &options = {}, const Length_Prefix &prefix = {});
+		~Async_File_Source();
+
+		Async_File_Source(const Async_File_Source &) = delete;
+		Async_File_Source &operator=(const Async_File_Source &) = delete;
+
+		/// <summary>
+		/// Get the next region of the file in order, resubmitting the previous chunk to prefetch further ahead.
+		/// </summary>
+		/// <param name="data">Receives a pointer to the region, valid until the next call</param>
+		/// <param name="size">Receives the size of the region</param>
+		/// <exception cref="runtime_error">Occurs if a read failed</exception>
+		/// <returns>false at the end of the file</returns>
+		bool next_chunk(const unsigned char *&data, size_t &size);
+
+		/// <summary>
+		/// Get the next length-prefixed frame. Frames inside a chunk are returned in place, frames crossing chunks are assembled first.
+		/// <para>Don't mix with next_chunk().</para>
+		/// </summary>
+		/// <param name="frame">Receives a non-owning view over the frame, valid until the next call</param>
+		/// <exception cref="runtime_error">Occurs if a read failed or the file ends in the middle of a frame</exception>
+		/// <returns>false at the end of the file</returns>
+		bool next(Deserializer &frame);
+
+		/// <summary>
+		/// Get the size of the file when it was opened.
+		/// </summary>
+		/// <returns>Size in bytes</returns>
+		unsigned long long get_file_size() const;
+
+		/// <summary>
+		/// Get the backend actually used.
+		/// </summary>
+		/// <returns>IO_URING or THREAD_POOL</returns>
+		Async_Backend get_backend() const;
+
+	private:
+		struct Chunk
+		{
+			std::unique_ptr<unsigned char[]> data;
+			size_t size = 0;
+			size_t done = 0;
+			unsigned long long offset = 0;
+			bool in_flight = false;
+		};
+
+		int fd = -1;
+		size_t chunk_size;
+		Length_Prefix prefix;
+		std::unique_ptr<Async_Io_Backend> backend;
+		std::vector<Chunk> chunks;
+
+		unsigned long long file_size = 0;
+		unsigned long long next_read_offset = 0;
+		unsigned long long next_chunk_number = 0;
+		bool has_current = false;
+		size_t current = 0;
+
+		const unsigned char *chunk_data = nullptr;
+		size_t chunk_remaining = 0;
+		std::vector<unsigned char> assembly;
+
+		void submit(size_t chunk);
+		void wait_one();
+		bool pull_chunk();
+		bool append_to_assembly(size_t size);
+		void release();
+	};
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	/// <summary>
+	/// Bytes before the offset table of a batch: 4 bytes Big-Endian batch size followed by 4 bytes Big-Endian message count.
+	/// </summary>
+	static const size_t BATCH_HEADER_SIZE = 8;
+
+	struct Batch_Flush_Policy
+	{
+		/// <summary>
+		/// Payload bytes that make the batch ready to be flushed.
+		/// </summary>
+		size_t max_bytes = 64 * 1024;
+
+		/// <summary>
+		/// Amount of messages that make the batch ready to be flushed.
+		/// </summary>
+		size_t max_messages = 1024;
+
+		/// <summary>
+		/// Maximum time the first message of a batch waits before the batch is ready to be flushed.
+		/// </summary>
+		std::chrono::microseconds max_latency = std::chrono::microseconds(1000);
+	};
+
+	class Batch_Builder
+	{
+	public:
+		/// <summary>
+		/// Constructs an empty batch builder.
+		/// </summary>
+		/// <param name="policy">Thresholds used by should_flush()</param>
+		Batch_Builder(const Batch_Flush_Policy &policy = {});
+
+		/// <summary>
+		/// Appends a message to the batch.
+		/// </summary>
+		/// <param name="message">Pointer to the first byte of the message</param>
+		/// <param name="size">Size of the message</param>
+		/// <exception cref="runtime_error">Occurs if the encoded envelope would exceed 4 GiB</exception>
+		/// <returns>Reference to the builder object (allows chaining methods)</returns>
+		Batch_Builder &add(const unsigned char *message, size_t size);
+
+		/// <summary>
+		/// Appends a message to the batch.
+		/// </summary>
+		/// <param name="message">Bytes of the message</param>
+		/// <returns>Reference to the builder object (allows chaining methods)</returns>
+		Batch_Builder &add(const std::vector<unsigned char> &message);
+
+		/// <summary>
+		/// Appends a serializable object as a message of the batch.
+		/// </summary>
+		/// <param name="object">Object that implements Serializable interface</param>
+		/// <returns>Reference to the builder object (allows chaining methods)</returns>
+		Batch_Builder &add(const Serializable &object);
+
+		/// <summary>
+		/// Check whether the batch reached any threshold of the flush policy (bytes, messages or latency of the first message).
+		/// </summary>
+		/// <returns>true if the batch should be flushed</returns>
+		bool should_flush() const;
+
+		/// <summary>
+		/// Builds the batch envelope: batch size, message count, one 4 bytes Big-Endian end offset per message (relative to the first payload byte) and the concatenated payloads.
+		/// <para>The builder is emptied afterwards, keeping its buffers for the next batch. The returned reference is valid until the next finish() call.</para>
+		/// </summary>
+		/// <returns>Vector with the batch envelope</returns>
+		const std::vector<unsigned char> &finish();
+
+		/// <summary>
+		/// Get the amount of messages in the batch.
+		/// </summary>
+		/// <returns>Amount of messages</returns>
+		size_t get_message_count() const;
+
+		/// <summary>
+		/// Check whether the batch has no message.
+		/// </summary>
+		/// <returns>true if the batch is empty</returns>
+		bool empty() const;
+
+	private:
+		Batch_Flush_Policy policy;
+
+		std::vector<unsigned char> payloads;
+		std::vector<unsigned int> ends;
+		std::chrono::steady_clock::time_point first_message_time;
+
+		Serializer envelope;
+	};
+
+	class Batch_Reader
+	{
+	public:
+		class Iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Deserializer;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = Deserializer;
+
+			Iterator(const Batch_Reader *reader, size_t message);
+
+			Deserializer operator*() const;
+			Iterator &operator++();
+			bool operator==(const Iterator &other) const;
+			bool operator!=(const Iterator &other) const;
+
+		private:
+			const Batch_Reader *reader;
+			size_t message;
+		};
+
+		/// <summary>
+		/// Parses the header and offset table of a batch envelope without copying it.
+		/// </summary>
+		/// <param name="data">Pointer to the first byte of the envelope, which must outlive the reader</param>
+		/// <param name="size">Amount of bytes available at <paramref name="data"/></param>
+		/// <exception cref="runtime_error">Occurs if the envelope is truncated or its offset table is invalid</exception>
+		Batch_Reader(const unsigned char *data, size_t size);
+
+		/// <summary>
+		/// Parses the next batch envelope of <paramref name="deserializer"/>, moving its cursor past the envelope.
+		/// </summary>
+		/// <param name="deserializer">Deserializer positioned at the start of the envelope, whose bytes must outlive the reader</param>
+		/// <exception cref="runtime_error">Occurs if the envelope is truncated or its offset table is invalid</exception>
+		Batch_Reader(Deserializer &deserializer);
+
+		/// <summary>
+		/// Get the amount of messages in the batch.
+		/// </summary>
+		/// <returns>Amount of messages</returns>
+		size_t get_message_count() const;
+
+		/// <summary>
+		/// Get the total size of the envelope.
+		/// </summary>
+		/// <returns>Envelope size</returns>
+		size_t get_batch_size() const;
+
+		/// <summary>
+		/// Get a non-owning deserializer over the message <paramref name="message"/>.
+		/// </summary>
+		/// <param name="message">Index of the message, starting from 0</param>
+		/// <exception cref="runtime_error">Occurs if the message doesn't exist</exception>
+		/// <returns>Deserializer view over the message</returns>
+		Deserializer get_message(size_t message) const;
+
+		Iterator begin() const;
+		Iterator end() const;
+
+	private:
+		void parse(const unsigned char *data, size_t size);
+		size_t end_of(size_t message) const;
+
+	private:
+		const unsigned char *offsets = nullptr;
+		const unsigned char *payloads = nullptr;
+		size_t message_count = 0;
+		size_t batch_size = 0;
+	};
+}
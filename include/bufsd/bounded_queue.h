@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+namespace bufsd
+{
+	/// <summary>
+	/// Bounded lock-free queue for any amount of producers and consumers (Vyukov's array-based design).
+	/// <para>Every cell carries a sequence number telling whether it is ready to be written or read, so producers and consumers only contend on their own position counter.</para>
+	/// </summary>
+	/// <typeparam name="T">Type of the elements, copied in and out of the cells</typeparam>
+	template <typename T>
+	class Bounded_Queue
+	{
+	public:
+		/// <summary>
+		/// Constructs an empty queue.
+		/// </summary>
+		/// <param name="capacity">Maximum amount of elements, rounded up to a power of two</param>
+		explicit Bounded_Queue(size_t capacity)
+		{
+			size_t size = 2;
+			while (size < capacity)
+				size <<= 1;
+
+			this->cells.reset(new Cell[size]);
+			this->mask = size - 1;
+
+			for (size_t i = 0; i < size; i++)
+				this->cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		Bounded_Queue(const Bounded_Queue &) = delete;
+		Bounded_Queue &operator=(const Bounded_Queue &) = delete;
+
+		/// <summary>
+		/// Appends <paramref name="value"/> unless the queue is full.
+		/// </summary>
+		/// <param name="value">Element to append</param>
+		/// <returns>false if the queue is full</returns>
+		bool try_push(const T &value)
+		{
+			size_t position = this->enqueue_position.load(std::memory_order_relaxed);
+
+			while (true)
+			{
+				Cell &cell = this->cells[position & this->mask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+
+				if (difference == 0)
+				{
+					if (this->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						cell.value = value;
+						cell.sequence.store(position + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = this->enqueue_position.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Removes the oldest element unless the queue is empty.
+		/// </summary>
+		/// <param name="value">Receives the element</param>
+		/// <returns>false if the queue is empty</returns>
+		bool try_pop(T &value)
+		{
+			size_t position = this->dequeue_position.load(std::memory_order_relaxed);
+
+			while (true)
+			{
+				Cell &cell = this->cells[position & this->mask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+
+				if (difference == 0)
+				{
+					if (this->dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						value = cell.value;
+						cell.sequence.store(position + this->mask + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = this->dequeue_position.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Get the maximum amount of elements.
+		/// </summary>
+		/// <returns>Capacity of the queue</returns>
+		size_t get_capacity() const
+		{
+			return this->mask + 1;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Cell[]> cells;
+		size_t mask;
+
+		alignas(64) std::atomic<size_t> enqueue_position{0};
+		alignas(64) std::atomic<size_t> dequeue_position{0};
+	};
+}
@@ -0,0 +1,443 @@
+#pragma once
+
+#include <map>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <utility>
+#include <variant>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include "bufsd/framing.h"
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+#include "bufsd/serializable.h"
+#include "bufsd/deserializable.h"
+
+namespace bufsd
+{
+	/// <summary>
+	/// Wire format used by the codecs.
+	/// </summary>
+	struct Codec_Options
+	{
+		/// <summary>
+		/// Byte order of numbers.
+		/// </summary>
+		Endianness endianness = Endianness::BIG;
+
+		/// <summary>
+		/// Prefix holding the amount of elements of containers and the amount of bytes of strings.
+		/// </summary>
+		Length_Prefix length_prefix = {};
+	};
+
+	/// <summary>
+	/// Encodes and decodes values of type <typeparamref name="T"/>. Specialize it to make more types usable with push_value, get_value and fill_value, providing:
+	/// <para>static void push(Serializer &amp;serializer, const T &amp;value, const Codec_Options &amp;options)</para>
+	/// <para>static void fill(Deserializer &amp;deserializer, T &amp;value, const Codec_Options &amp;options)</para>
+	/// </summary>
+	/// <typeparam name="T">Type of the values</typeparam>
+	template <typename T, typename Enable = void>
+	struct Codec;
+
+	/// <summary>
+	/// Pushes <paramref name="value"/> with the codec of its type.
+	/// </summary>
+	/// <param name="serializer">Buffer maker receiving the value</param>
+	/// <param name="value">Value to be pushed</param>
+	/// <param name="options">Wire format</param>
+	/// <exception cref="runtime_error">Occurs if a length doesn't fit in the length prefix or its width is not between 1 and 8</exception>
+	template <typename T>
+	void push_value(Serializer &serializer, const T &value, const Codec_Options &options = {})
+	{
+		Codec<T>::push(serializer, value, options);
+	}
+
+	/// <summary>
+	/// Fills an existing <paramref name="value"/> with the codec of its type. Containers and strings already in it are refilled, keeping their capacity.
+	/// <para>Since it uses the deserializer's buffer, it moves the cursor forward.</para>
+	/// </summary>
+	/// <param name="deserializer">The deserializer contaning the bytes that will be used</param>
+	/// <param name="value">Value to be filled</param>
+	/// <param name="options">Wire format</param>
+	/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer, the bytes are not a valid encoding or the length prefix width is not between 1 and 8</exception>
+	template <typename T>
+	void fill_value(Deserializer &deserializer, T &value, const Codec_Options &options = {})
+	{
+		Codec<T>::fill(deserializer, value, options);
+	}
+
+	/// <summary>
+	/// Get the next value of type <typeparamref name="T"/> with its codec.
+	/// <para>Since it uses the deserializer's buffer, it moves the cursor forward.</para>
+	/// </summary>
+	/// <typeparam name="T">Default constructible type of the value</typeparam>
+	/// <param name="deserializer">The deserializer contaning the bytes that will be used</param>
+	/// <param name="options">Wire format</param>
+	/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer, the bytes are not a valid encoding or the length prefix width is not between 1 and 8</exception>
+	/// <returns>The decoded value</returns>
+	template <typename T>
+	T get_value(Deserializer &deserializer, const Codec_Options &options = {})
+	{
+		T value{};
+		Codec<T>::fill(deserializer, value, options);
+
+		return value;
+	}
+
+	namespace codec_detail
+	{
+		// Arithmetic types whose bytes can be copied as a block (bool excluded: not every byte is a valid bool)
+		template <typename T>
+		constexpr bool is_bulk_copyable = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value;
+
+		inline void push_length(Serializer &serializer, size_t length, const Codec_Options &options)
+		{
+			unsigned char bytes[8];
+			options.length_prefix.write(bytes, length);
+
+			serializer.push_buffer(bytes, options.length_prefix.number_of_bytes);
+		}
+
+		inline size_t get_length(Deserializer &deserializer, const Codec_Options &options)
+		{
+			options.length_prefix.validate();
+
+			size_t length = (size_t)deserializer.peek_integer(0, options.length_prefix.number_of_bytes, options.length_prefix.endianness);
+			deserializer.skip(options.length_prefix.number_of_bytes);
+
+			return length;
+		}
+
+		// Every element takes at least one byte, so a corrupted count is caught before allocating
+		inline size_t get_count(Deserializer &deserializer, const Codec_Options &options)
+		{
+			size_t count = get_length(deserializer, options);
+
+			if (count > deserializer.get_remaining())
+				throw std::runtime_error("Container of " + std::to_string(count) + " element(s) can't fit in the " + std::to_string(deserializer.get_remaining()) + " byte(s) remaining");
+
+			return count;
+		}
+	}
+
+	template <typename T>
+	struct Codec<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+	{
+		static void push(Serializer &serializer, const T &value, const Codec_Options &options)
+		{
+			serializer.push_array(&value, 1, options.endianness);
+		}
+
+		static void fill(Deserializer &deserializer, T &value, const Codec_Options &options)
+		{
+			if constexpr (std::is_same<T, bool>::value)
+			{
+				unsigned char byte = deserializer.get_byte();
+
+				if (byte > 1)
+					throw std::runtime_error("Invalid bool value " + std::to_string(byte));
+
+				value = byte == 1;
+			}
+			else
+				deserializer.get_array(1, &value, options.endianness);
+		}
+	};
+
+	template <typename T>
+	struct Codec<T, typename std::enable_if<std::is_enum<T>::value>::type>
+	{
+		using Underlying = typename std::underlying_type<T>::type;
+
+		static void push(Serializer &serializer, const T &value, const Codec_Options &options)
+		{
+			Codec<Underlying>::push(serializer, (Underlying)value, options);
+		}
+
+		static void fill(Deserializer &deserializer, T &value, const Codec_Options &options)
+		{
+			Underlying underlying{};
+			Codec<Underlying>::fill(deserializer, underlying, options);
+
+			value = (T)underlying;
+		}
+	};
+
+	template <>
+	struct Codec<std::string>
+	{
+		static void push(Serializer &serializer, const std::string &value, const Codec_Options &options)
+		{
+			codec_detail::push_length(serializer, value.size(), options);
+			serializer.push_buffer((const unsigned char *)value.data(), value.size());
+		}
+
+		static void fill(Deserializer &deserializer, std::string &value, const Codec_Options &options)
+		{
+			deserializer.get_string(codec_detail::get_length(deserializer, options), value);
+		}
+	};
+
+	template <typename T, typename Allocator>
+	struct Codec<std::vector<T, Allocator>>
+	{
+		static void push(Serializer &serializer, const std::vector<T, Allocator> &value, const Codec_Options &options)
+		{
+			codec_detail::push_length(serializer, value.size(), options);
+
+			if constexpr (codec_detail::is_bulk_copyable<T>)
+				serializer.push_array(value.data(), value.size(), options.endianness);
+			else
+			{
+				for (const T &element : value)
+					Codec<T>::push(serializer, element, options);
+			}
+		}
+
+		static void fill(Deserializer &deserializer, std::vector<T, Allocator> &value, const Codec_Options &options)
+		{
+			if constexpr (codec_detail::is_bulk_copyable<T>)
+			{
+				size_t count = codec_detail::get_length(deserializer, options);
+
+				// Same check as get_array for std::vector, which can't take a custom allocator
+				value.resize(count <= deserializer.get_remaining() / sizeof(T) ? count : 0);
+				deserializer.get_array(count, value.data(), options.endianness);
+			}
+			else
+			{
+				value.resize(codec_detail::get_count(deserializer, options));
+
+				for (T &element : value)
+					Codec<T>::fill(deserializer, element, options);
+			}
+		}
+	};
+
+	template <typename Allocator>
+	struct Codec<std::vector<bool, Allocator>>
+	{
+		static void push(Serializer &serializer, const std::vector<bool, Allocator> &value, const Codec_Options &options)
+		{
+			codec_detail::push_length(serializer, value.size(), options);
+
+			for (bool element : value)
+				serializer.push_byte((unsigned char)element);
+		}
+
+		static void fill(Deserializer &deserializer, std::vector<bool, Allocator> &value, const Codec_Options &options)
+		{
+			value.resize(codec_detail::get_count(deserializer, options));
+
+			for (size_t i = 0; i < value.size(); i++)
+			{
+				bool element = false;
+				Codec<bool>::fill(deserializer, element, options);
+
+				value[i] = element;
+			}
+		}
+	};
+
+	template <typename T, size_t N>
+	struct Codec<std::array<T, N>>
+	{
+		static void push(Serializer &serializer, const std::array<T, N> &value, const Codec_Options &options)
+		{
+			if constexpr (codec_detail::is_bulk_copyable<T>)
+				serializer.push_array(value.data(), N, options.endianness);
+			else
+			{
+				for (const T &element : value)
+					Codec<T>::push(serializer, element, options);
+			}
+		}
+
+		static void fill(Deserializer &deserializer, std::array<T, N> &value, const Codec_Options &options)
+		{
+			if constexpr (codec_detail::is_bulk_copyable<T>)
+				deserializer.get_array(N, value.data(), options.endianness);
+			else
+			{
+				for (T &element : value)
+					Codec<T>::fill(deserializer, element, options);
+			}
+		}
+	};
+
+	template <typename T>
+	struct Codec<std::optional<T>>
+	{
+		static void push(Serializer &serializer, const std::optional<T> &value, const Codec_Options &options)
+		{
+			serializer.push_byte((unsigned char)value.has_value());
+
+			if (value)
+				Codec<T>::push(serializer, *value, options);
+		}
+
+		static void fill(Deserializer &deserializer, std::optional<T> &value, const Codec_Options &options)
+		{
+			unsigned char present = deserializer.get_byte();
+
+			if (present > 1)
+				throw std::runtime_error("Invalid optional presence flag " + std::to_string(present));
+
+			if (!present)
+				return value.reset();
+
+			if (!value)
+				value.emplace();
+
+			Codec<T>::fill(deserializer, *value, options);
+		}
+	};
+
+	template <typename... Types>
+	struct Codec<std::variant<Types...>>
+	{
+		static_assert(sizeof...(Types) <= 255, "Variant indexes are encoded in 1 byte");
+
+		static void push(Serializer &serializer, const std::variant<Types...> &value, const Codec_Options &options)
+		{
+			if (value.valueless_by_exception())
+				throw std::runtime_error("Can't push a valueless variant");
+
+			serializer.push_byte((unsigned char)value.index());
+			std::visit([&serializer, &options](const auto &alternative)
+					   { Codec<typename std::decay<decltype(alternative)>::type>::push(serializer, alternative, options); },
+					   value);
+		}
+
+		static void fill(Deserializer &deserializer, std::variant<Types...> &value, const Codec_Options &options)
+		{
+			size_t index = deserializer.get_byte();
+
+			if (index >= sizeof...(Types))
+				throw std::runtime_error("Invalid variant index " + std::to_string(index) + " for " + std::to_string(sizeof...(Types)) + " alternative(s)");
+
+			fill_index(deserializer, value, options, index, std::index_sequence_for<Types...>{});
+		}
+
+	private:
+		using Filler = void (*)(Deserializer &, std::variant<Types...> &, const Codec_Options &);
+
+		template <size_t I>
+		static void fill_alternative(Deserializer &deserializer, std::variant<Types...> &value, const Codec_Options &options)
+		{
+			using Alternative = typename std::variant_alternative<I, std::variant<Types...>>::type;
+
+			// The alternative already held is refilled, keeping its capacity
+			Alternative *alternative = std::get_if<I>(&value);
+			if (!alternative)
+				alternative = &value.template emplace<I>();
+
+			Codec<Alternative>::fill(deserializer, *alternative, options);
+		}
+
+		template <size_t... I>
+		static void fill_index(Deserializer &deserializer, std::variant<Types...> &value, const Codec_Options &options, size_t index, std::index_sequence<I...>)
+		{
+			static const Filler fillers[] = {&Codec::fill_alternative<I>...};
+
+			fillers[index](deserializer, value, options);
+		}
+	};
+
+	template <typename First, typename Second>
+	struct Codec<std::pair<First, Second>>
+	{
+		static void push(Serializer &serializer, const std::pair<First, Second> &value, const Codec_Options &options)
+		{
+			Codec<First>::push(serializer, value.first, options);
+			Codec<Second>::push(serializer, value.second, options);
+		}
+
+		static void fill(Deserializer &deserializer, std::pair<First, Second> &value, const Codec_Options &options)
+		{
+			Codec<First>::fill(deserializer, value.first, options);
+			Codec<Second>::fill(deserializer, value.second, options);
+		}
+	};
+
+	namespace codec_detail
+	{
+		template <typename Map>
+		void push_map(Serializer &serializer, const Map &value, const Codec_Options &options)
+		{
+			push_length(serializer, value.size(), options);
+
+			for (const auto &entry : value)
+			{
+				Codec<typename Map::key_type>::push(serializer, entry.first, options);
+				Codec<typename Map::mapped_type>::push(serializer, entry.second, options);
+			}
+		}
+
+		template <typename Map>
+		void fill_map(Deserializer &deserializer, Map &value, const Codec_Options &options)
+		{
+			size_t count = get_count(deserializer, options);
+			value.clear();
+
+			for (size_t i = 0; i < count; i++)
+			{
+				typename Map::key_type key{};
+				typename Map::mapped_type mapped{};
+
+				Codec<typename Map::key_type>::fill(deserializer, key, options);
+				Codec<typename Map::mapped_type>::fill(deserializer, mapped, options);
+
+				value.emplace_hint(value.end(), std::move(key), std::move(mapped));
+			}
+		}
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator>
+	struct Codec<std::map<Key, Value, Compare, Allocator>>
+	{
+		static void push(Serializer &serializer, const std::map<Key, Value, Compare, Allocator> &value, const Codec_Options &options)
+		{
+			codec_detail::push_map(serializer, value, options);
+		}
+
+		static void fill(Deserializer &deserializer, std::map<Key, Value, Compare, Allocator> &value, const Codec_Options &options)
+		{
+			codec_detail::fill_map(deserializer, value, options);
+		}
+	};
+
+	template <typename Key, typename Value, typename Hash, typename Equal, typename Allocator>
+	struct Codec<std::unordered_map<Key, Value, Hash, Equal, Allocator>>
+	{
+		static void push(Serializer &serializer, const std::unordered_map<Key, Value, Hash, Equal, Allocator> &value, const Codec_Options &options)
+		{
+			codec_detail::push_map(serializer, value, options);
+		}
+
+		static void fill(Deserializer &deserializer, std::unordered_map<Key, Value, Hash, Equal, Allocator> &value, const Codec_Options &options)
+		{
+			codec_detail::fill_map(deserializer, value, options);
+		}
+	};
+
+	template <typename T>
+	struct Codec<T, typename std::enable_if<std::is_base_of<Serializable, T>::value && std::is_base_of<Deserializable<T>, T>::value>::type>
+	{
+		static void push(Serializer &serializer, const T &value, const Codec_Options &)
+		{
+			serializer.push_object(value);
+		}
+
+		static void fill(Deserializer &deserializer, T &value, const Codec_Options &)
+		{
+			value.fill_from_bytes(deserializer);
+		}
+	};
+}
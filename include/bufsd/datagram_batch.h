@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+
+// Only declared by <sys/socket.h> on Linux, so the members below still parse elsewhere
+struct mmsghdr;
+
+namespace bufsd
+{
+	class Datagram_Batch_Sender
+	{
+	public:
+		/// <summary>
+		/// Constructs a sender with <paramref name="capacity"/> preallocated datagram slots writing to the UDP socket <paramref name="fd"/> (Linux only).
+		/// </summary>
+		/// <param name="fd">UDP socket, not owned by the sender</param>
+		/// <param name="capacity">Maximum amount of datagrams per batch</param>
+		Datagram_Batch_Sender(int fd, size_t capacity = 64);
+		~Datagram_Batch_Sender();
+
+		Datagram_Batch_Sender(const Datagram_Batch_Sender &) = delete;
+		Datagram_Batch_Sender &operator=(const Datagram_Batch_Sender &) = delete;
+
+		/// <summary>
+		/// Get the next empty slot, where a datagram can be serialized in place.
+		/// <para>Slots keep their allocated capacity between batches.</para>
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if every slot is already used</exception>
+		/// <returns>Serializer of the slot</returns>
+		Serializer &next_slot();
+
+		/// <summary>
+		/// Sends every used slot with sendmmsg and empties the batch.
+		/// <para>On a non-blocking socket the datagrams that didn't fit are dropped, as a UDP socket would do.</para>
+		/// </summary>
+		/// <param name="destination">Destination address, or nullptr for a connected socket</param>
+		/// <param name="destination_length">Size of <paramref name="destination"/></param>
+		/// <exception cref="runtime_error">Occurs if sendmmsg fails</exception>
+		/// <returns>Amount of datagrams sent</returns>
+		size_t send(const struct sockaddr *destination = nullptr, socklen_t destination_length = 0);
+
+		/// <summary>
+		/// Get the amount of used slots.
+		/// </summary>
+		/// <returns>Amount of datagrams in the batch</returns>
+		size_t get_datagram_count() const;
+
+		/// <summary>
+		/// Check whether every slot is used.
+		/// </summary>
+		/// <returns>true if the batch is full</returns>
+		bool full() const;
+
+	private:
+		int fd;
+		std::vector<Serializer> slots;
+		size_t used = 0;
+
+		// Sized once at construction, so a batch doesn't allocate
+		std::vector<struct iovec> iovecs;
+		std::vector<struct mmsghdr> messages;
+	};
+
+	class Datagram_Batch_Receiver
+	{
+	public:
+		/// <summary>
+		/// Constructs a receiver with <paramref name="capacity"/> preallocated slots of <paramref name="slot_size"/> bytes reading from the UDP socket <paramref name="fd"/> (Linux only).
+		/// </summary>
+		/// <param name="fd">UDP socket, not owned by the receiver</param>
+		/// <param name="capacity">Maximum amount of datagrams per receive() call</param>
+		/// <param name="slot_size">Maximum datagram size, bigger datagrams are truncated</param>
+		Datagram_Batch_Receiver(int fd, size_t capacity = 64, size_t slot_size = 2048);
+		~Datagram_Batch_Receiver();
+
+		Datagram_Batch_Receiver(const Datagram_Batch_Receiver &) = delete;
+		Datagram_Batch_Receiver &operator=(const Datagram_Batch_Receiver &) = delete;
+
+		/// <summary>
+		/// Receives up to capacity datagrams with a single recvmmsg call, waiting only for the first one.
+		/// <para>Invalidates the views handed out for the previous batch.</para>
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if recvmmsg fails</exception>
+		/// <returns>Amount of datagrams received (0 if a non-blocking socket has no data)</returns>
+		size_t receive();
+
+		/// <summary>
+		/// Get the amount of datagrams of the last receive() call.
+		/// </summary>
+		/// <returns>Amount of datagrams</returns>
+		size_t get_datagram_count() const;
+
+		/// <summary>
+		/// Get a non-owning deserializer over the datagram <paramref name="datagram"/>, decoded in place in its slot.
+		/// </summary>
+		/// <param name="datagram">Index of the datagram, starting from 0</param>
+		/// <exception cref="runtime_error">Occurs if the datagram doesn't exist</exception>
+		/// <returns>Deserializer view over the datagram, valid until the next receive() call</returns>
+		Deserializer get_datagram(size_t datagram) const;
+
+		/// <summary>
+		/// Check whether the datagram <paramref name="datagram"/> was bigger than the slot size and got truncated.
+		/// </summary>
+		/// <param name="datagram">Index of the datagram, starting from 0</param>
+		/// <returns>true if the datagram was truncated</returns>
+		bool is_truncated(size_t datagram) const;
+
+		/// <summary>
+		/// Receives once and hands every datagram to <paramref name="handler"/>.
+		/// </summary>
+		/// <param name="handler">Called with a view over each datagram</param>
+		/// <exception cref="runtime_error">Occurs if recvmmsg fails</exception>
+		/// <returns>Amount of datagrams handled</returns>
+		size_t poll(const std::function<void(Deserializer &datagram)> &handler);
+
+	private:
+		int fd;
+		size_t capacity;
+		size_t slot_size;
+
+		std::vector<unsigned char> storage;
+		std::vector<size_t> sizes;
+		std::vector<bool> truncated;
+		size_t received = 0;
+
+		// Point into storage and are built once at construction
+		std::vector<struct iovec> iovecs;
+		std::vector<struct mmsghdr> messages;
+	};
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace bufsd
+{
+	struct Delta_Options
+	{
+		/// <summary>
+		/// Size of the base buffer blocks indexed for moved-content matching.
+		/// </summary>
+		size_t block_size = 32;
+
+		/// <summary>
+		/// Minimum run of equal bytes (at the same offset) worth encoding as a copy instead of a literal.
+		/// </summary>
+		size_t min_match = 16;
+	};
+
+	/// <summary>
+	/// Encodes the difference between <paramref name="base"/> and <paramref name="target"/> as a sequence of copy and literal operations.
+	/// <para>Bytes that stay at the same offset are found with a vectorized compare, moved content is found by matching hashed blocks of <paramref name="base"/>, and everything else is emitted as literal runs, so the delta size is proportional to the change.</para>
+	/// </summary>
+	/// <param name="base">The buffer the receiver already has</param>
+	/// <param name="target">The new buffer</param>
+	/// <param name="options">Matching parameters</param>
+	/// <exception cref="runtime_error">Occurs if the block size or the minimum match is 0</exception>
+	/// <returns>Vector with the encoded delta</returns>
+	std::vector<unsigned char> make_delta(const std::vector<unsigned char> &base, const std::vector<unsigned char> &target, const Delta_Options &options = {});
+
+	/// <summary>
+	/// Rebuilds the target buffer from <paramref name="base"/> and a delta created by make_delta, writing it to <paramref name="output"/>.
+	/// <para>Reusing the same <paramref name="output"/> across calls avoids reallocating it for every snapshot.</para>
+	/// </summary>
+	/// <param name="base">The buffer used as base when the delta was created</param>
+	/// <param name="delta">The encoded delta</param>
+	/// <param name="output">Where the rebuilt buffer will be written</param>
+	/// <exception cref="runtime_error">Occurs if the delta is malformed or was created from a base of different size</exception>
+	void apply_delta(const std::vector<unsigned char> &base, const std::vector<unsigned char> &delta, std::vector<unsigned char> &output);
+
+	/// <summary>
+	/// Rebuilds the target buffer from <paramref name="base"/> and a delta created by make_delta.
+	/// </summary>
+	/// <param name="base">The buffer used as base when the delta was created</param>
+	/// <param name="delta">The encoded delta</param>
+	/// <exception cref="runtime_error">Occurs if the delta is malformed or was created from a base of different size</exception>
+	/// <returns>Vector with the rebuilt buffer</returns>
+	std::vector<unsigned char> apply_delta(const std::vector<unsigned char> &base, const std::vector<unsigned char> &delta);
+}
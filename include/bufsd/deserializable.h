@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
 
 #include "bufsd/deserializer.h"
 
@@ -55,5 +58,92 @@ namespace bufsd
 
 			return object;
 		}
+
+		/// <summary>
+		/// Creates <paramref name="count"/> objects stored back to back in deserializer's bytes.
+		/// <para>Reserves the vector once and fills each object where it lives, instead of moving a temporary per object. Since it uses the deserializer's buffer, it moves the cursor forward.</para>
+		/// </summary>
+		/// <param name="deserializer">The deserializer contaning the bytes that will be used</param>
+		/// <param name="count">Amount of objects to read</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>Vector with the newly created objects</returns>
+		static std::vector<T> from_bytes_many(Deserializer &deserializer, size_t count)
+		{
+			std::vector<T> objects;
+
+			Deserializable::fill_many_from_bytes(deserializer, count, objects);
+
+			return objects;
+		}
+
+		/// <summary>
+		/// Fills <paramref name="objects"/> with <paramref name="count"/> objects stored back to back in deserializer's bytes.
+		/// <para>Objects already in the vector are refilled in place, keeping the capacity of their own strings and vectors. Since it uses the deserializer's buffer, it moves the cursor forward.</para>
+		/// </summary>
+		/// <param name="deserializer">The deserializer contaning the bytes that will be used</param>
+		/// <param name="count">Amount of objects to read</param>
+		/// <param name="objects">Vector receiving the objects (resized to <paramref name="count"/>, or to the objects read before a non-throwing deserializer failed)</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer (the objects are then partially filled)</exception>
+		static void fill_many_from_bytes(Deserializer &deserializer, size_t count, std::vector<T> &objects)
+		{
+			// Every object takes at least one byte in practice, so a corrupted count can't reserve more than the buffer size
+			objects.reserve(std::min(count, deserializer.get_remaining()));
+
+			size_t filled = 0;
+
+			for (; filled < count; filled++)
+			{
+				if (filled == objects.size())
+					objects.emplace_back();
+
+				objects[filled].fill_from_bytes(deserializer);
+
+				// A non-throwing deserializer keeps returning zeroes once it fails, so the rest of the count would only spin
+				if (deserializer.has_failed())
+					break;
+			}
+
+			objects.resize(filled);
+		}
+
+		/// <summary>
+		/// Fills <paramref name="objects"/> with the objects stored back to back in the next <paramref name="region_size"/> bytes, for formats that store a byte length instead of a count.
+		/// <para>Objects already in the vector are refilled in place. Moves the cursor <paramref name="region_size"/> bytes forward.</para>
+		/// </summary>
+		/// <param name="deserializer">The deserializer contaning the bytes that will be used</param>
+		/// <param name="region_size">Amount of bytes holding the objects</param>
+		/// <param name="objects">Vector receiving the objects (resized to the amount read)</param>
+		/// <param name="size_hint">Expected size of an encoded object, used to reserve the vector once (0 lets it grow)</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer, the last object crosses the end of the region or an object reads no byte</exception>
+		static void fill_region_from_bytes(Deserializer &deserializer, size_t region_size, std::vector<T> &objects, size_t size_hint = 0)
+		{
+			Deserializer region = deserializer.get_view(region_size);
+
+			if (size_hint > 0)
+				objects.reserve(region_size / size_hint + 1);
+
+			size_t count = 0;
+
+			for (; region.get_remaining() > 0; count++)
+			{
+				if (count == objects.size())
+					objects.emplace_back();
+
+				size_t start = region.get_cursor();
+				objects[count].fill_from_bytes(region);
+
+				// The region is a view, so a failed read of a non-throwing deserializer is reported back on the deserializer itself
+				if (region.has_failed())
+				{
+					deserializer.restore({deserializer.get_cursor(), true});
+					break;
+				}
+
+				if (region.get_cursor() == start)
+					throw std::runtime_error("Could not split a region of " + std::to_string(region_size) + " bytes: an object read no byte");
+			}
+
+			objects.resize(count);
+		}
 	};
 }
\ No newline at end of file
@@ -2,6 +2,14 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "bufsd/utils.h"
+#include "bufsd/key_encoding.h"
 
 namespace bufsd
 {
@@ -25,6 +33,87 @@ namespace bufsd
 		/// <returns>Vector with the requested amount of bytes</returns>
 		std::vector<unsigned char> get_buffer(size_t size);
 
+		/// <summary>
+		/// Copies the <paramref name="size"/> next bytes of the buffer into <paramref name="destination"/>, replacing its content but keeping its capacity.
+		/// <para>Moves the cursor the same amount of bytes.</para>
+		/// </summary>
+		/// <param name="size">Amount of bytes to get from buffer</param>
+		/// <param name="destination">Vector receiving the bytes</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		void get_buffer(size_t size, std::vector<unsigned char> &destination);
+
+		/// <summary>
+		/// Copies the <paramref name="size"/> next bytes of the buffer into <paramref name="destination"/>, replacing its content but keeping its capacity.
+		/// <para>Moves the cursor the same amount of bytes.</para>
+		/// </summary>
+		/// <param name="size">Amount of bytes to get from buffer</param>
+		/// <param name="destination">String receiving the bytes</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		void get_string(size_t size, std::string &destination);
+
+		/// <summary>
+		/// Get a deserializer over the <paramref name="size"/> next bytes of the buffer without copying them.
+		/// <para>Moves the cursor the same amount of bytes. The returned deserializer reads this deserializer's bytes, so it must not outlive them.</para>
+		/// </summary>
+		/// <param name="size">Amount of bytes of the view</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>Non-owning deserializer over the requested bytes</returns>
+		Deserializer get_view(size_t size);
+
+		/// <summary>
+		/// Get the <paramref name="count"/> next numbers of the buffer, stored back to back with <paramref name="endianness"/> order, into <paramref name="destination"/>.
+		/// <para>Copies them all at once and only swaps bytes when <paramref name="endianness"/> is not the host's, instead of decoding one number at a time.</para>
+		/// <para>Moves the cursor count * sizeof(T) bytes forward.</para>
+		/// </summary>
+		/// <typeparam name="T">Arithmetic type of the numbers, whose size is the size of each stored number</typeparam>
+		/// <param name="count">Amount of numbers to get</param>
+		/// <param name="destination">Where the numbers are written (must have room for <paramref name="count"/> numbers, untouched if the read fails)</param>
+		/// <param name="endianness">Byte order of the stored numbers</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		template <typename T>
+		void get_array(size_t count, T *destination, Endianness endianness)
+		{
+			static_assert(std::is_arithmetic<T>::value, "get_array only reads numbers");
+
+			if (count > SIZE_MAX / sizeof(T))
+				return this->fail("Tried to get " + std::to_string(count) + " numbers, which is more than the address space");
+
+			const size_t size = count * sizeof(T);
+
+			if (!this->check_available(size) || size == 0)
+				return;
+
+			std::memcpy(destination, this->data + this->cursor, size);
+
+			if (sizeof(T) > 1 && endianness != get_host_endianness())
+			{
+				unsigned char *bytes = (unsigned char *)destination;
+
+				for (size_t i = 0; i < count; i++)
+					std::reverse(bytes + i * sizeof(T), bytes + (i + 1) * sizeof(T));
+			}
+
+			this->cursor += size;
+			this->update_remaining();
+		}
+
+		/// <summary>
+		/// Get the <paramref name="count"/> next numbers of the buffer into <paramref name="destination"/>, resized to <paramref name="count"/> (see the pointer overload). The capacity of <paramref name="destination"/> is kept.
+		/// </summary>
+		/// <typeparam name="T">Arithmetic type of the numbers, whose size is the size of each stored number</typeparam>
+		/// <param name="count">Amount of numbers to get</param>
+		/// <param name="destination">Vector receiving the numbers (emptied if the read fails)</param>
+		/// <param name="endianness">Byte order of the stored numbers</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		template <typename T>
+		void get_array(size_t count, std::vector<T> &destination, Endianness endianness)
+		{
+			// Sized only once the bytes are known to be there, so a corrupted count can't allocate
+			destination.resize(count <= this->remaining / sizeof(T) ? count : 0);
+
+			this->get_array(count, destination.data(), endianness);
+		}
+
 		/// <summary>
 		/// Get the next 2 bytes of the buffer in Big-Endian (not inverting the order).
 		/// <para>Moves the cursor 2 bytes forward.</para>
@@ -73,6 +162,109 @@ namespace bufsd
 		/// <returns>unsigned long long of the next 8 bytes of the buffer</returns>
 		unsigned long long get_64_little_endian();
 
+		/// <summary>
+		/// Get the next order-preserving key field pushed with Serializer::push_key.
+		/// <para>Moves the cursor sizeof(T) bytes forward.</para>
+		/// </summary>
+		/// <typeparam name="T">The type of the number, used to know how many bytes will be read</typeparam>
+		/// <param name="order">Sort direction the field was encoded with</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>The decoded value</returns>
+		template <typename T>
+		T get_key(Key_Order order = Key_Order::ASCENDING)
+		{
+			unsigned long long key = this->get_big_endian(sizeof(T));
+
+			if (order == Key_Order::DESCENDING)
+				key = ~key;
+
+			return from_key_bits<T>(key);
+		}
+
+		/// <summary>
+		/// Get the next order-preserving bytes key field pushed with Serializer::push_key, removing the escaping and the terminator.
+		/// <para>Moves the cursor to the byte after the field terminator.</para>
+		/// </summary>
+		/// <param name="order">Sort direction the field was encoded with</param>
+		/// <exception cref="runtime_error">Occurs when the field is not terminated or contains an invalid escape</exception>
+		/// <returns>Vector with the decoded bytes</returns>
+		std::vector<unsigned char> get_key_buffer(Key_Order order = Key_Order::ASCENDING);
+
+		/// <summary>
+		/// Get the next order-preserving string key field pushed with Serializer::push_key.
+		/// <para>Moves the cursor to the byte after the field terminator.</para>
+		/// </summary>
+		/// <param name="order">Sort direction the field was encoded with</param>
+		/// <exception cref="runtime_error">Occurs when the field is not terminated or contains an invalid escape</exception>
+		/// <returns>The decoded string</returns>
+		std::string get_key_string(Key_Order order = Key_Order::ASCENDING);
+
+		/// <summary>
+		/// Get the byte <paramref name="offset"/> bytes after the cursor without moving it.
+		/// </summary>
+		/// <param name="offset">Distance from the cursor to the byte</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>unsigned char of the byte</returns>
+		unsigned char peek_byte(size_t offset = 0) const;
+
+		/// <summary>
+		/// Get the 2 bytes <paramref name="offset"/> bytes after the cursor in Big-Endian without moving it.
+		/// </summary>
+		/// <param name="offset">Distance from the cursor to the first byte</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>unsigned short of the 2 bytes</returns>
+		unsigned short peek_16_big_endian(size_t offset = 0) const;
+
+		/// <summary>
+		/// Get the 4 bytes <paramref name="offset"/> bytes after the cursor in Big-Endian without moving it.
+		/// </summary>
+		/// <param name="offset">Distance from the cursor to the first byte</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>unsigned int of the 4 bytes</returns>
+		unsigned int peek_32_big_endian(size_t offset = 0) const;
+
+		/// <summary>
+		/// Get the 8 bytes <paramref name="offset"/> bytes after the cursor in Big-Endian without moving it.
+		/// </summary>
+		/// <param name="offset">Distance from the cursor to the first byte</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>unsigned long long of the 8 bytes</returns>
+		unsigned long long peek_64_big_endian(size_t offset = 0) const;
+
+		/// <summary>
+		/// Get the 2 bytes <paramref name="offset"/> bytes after the cursor in Little-Endian without moving it.
+		/// </summary>
+		/// <param name="offset">Distance from the cursor to the first byte</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>unsigned short of the 2 bytes</returns>
+		unsigned short peek_16_little_endian(size_t offset = 0) const;
+
+		/// <summary>
+		/// Get the 4 bytes <paramref name="offset"/> bytes after the cursor in Little-Endian without moving it.
+		/// </summary>
+		/// <param name="offset">Distance from the cursor to the first byte</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>unsigned int of the 4 bytes</returns>
+		unsigned int peek_32_little_endian(size_t offset = 0) const;
+
+		/// <summary>
+		/// Get the 8 bytes <paramref name="offset"/> bytes after the cursor in Little-Endian without moving it.
+		/// </summary>
+		/// <param name="offset">Distance from the cursor to the first byte</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>unsigned long long of the 8 bytes</returns>
+		unsigned long long peek_64_little_endian(size_t offset = 0) const;
+
+		/// <summary>
+		/// Get the <paramref name="amount_of_bytes"/> bytes <paramref name="offset"/> bytes after the cursor in <paramref name="endianness"/> order without moving it.
+		/// </summary>
+		/// <param name="offset">Distance from the cursor to the first byte</param>
+		/// <param name="amount_of_bytes">Amount of bytes of the number (1 to 8)</param>
+		/// <param name="endianness">Byte order of the number</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer</exception>
+		/// <returns>unsigned long long of the bytes</returns>
+		unsigned long long peek_integer(size_t offset, size_t amount_of_bytes, Endianness endianness) const;
+
 		/// <summary>
 		/// Get the current cursor position, starting from 0.
 		/// </summary>
@@ -91,6 +283,13 @@ namespace bufsd
 		/// <returns>Full buffer size</returns>
 		size_t get_buffer_size() const;
 
+		/// <summary>
+		/// Get a pointer to the first byte of the buffer (not the cursor position).
+		/// <para>The pointer is valid while the bytes read by this deserializer exist.</para>
+		/// </summary>
+		/// <returns>Pointer to the first byte of the buffer</returns>
+		const unsigned char *get_data() const;
+
 		/// <summary>
 		/// Move the cursor <paramref name="amount_of_bytes"/> bytes forward.
 		/// </summary>
@@ -107,8 +306,94 @@ namespace bufsd
 		/// Move the cursor to a given position
 		/// </summary>
 		/// <param name="position"></param>
+		/// <exception cref="runtime_error">Occurs when the position is beyond the end of the buffer</exception>
 		void set_cursor(size_t position);
 
+		/// <summary>
+		/// Cursor position and error state saved by checkpoint() to go back to them with restore().
+		/// </summary>
+		struct Checkpoint
+		{
+			size_t cursor;
+			bool failed;
+		};
+
+		/// <summary>
+		/// Saves the cursor position and the error state, so a speculative parse can be undone with restore().
+		/// </summary>
+		/// <returns>Checkpoint of the current state</returns>
+		Checkpoint checkpoint() const;
+
+		/// <summary>
+		/// Moves the cursor back to <paramref name="checkpoint"/> and restores the error state it had then.
+		/// </summary>
+		/// <param name="checkpoint">Checkpoint taken on this deserializer</param>
+		void restore(const Checkpoint &checkpoint);
+
+		/// <summary>
+		/// Chooses whether reading past the end of the buffer (or an invalid key field) throws, which is the default, or marks the deserializer as failed.
+		/// <para>When not throwing, a failed read returns 0 or an empty value and leaves the cursor in place, and has_failed() becomes true until restore() is called. Views created by get_view() inherit this mode.</para>
+		/// </summary>
+		/// <param name="throwing">true to throw runtime_error on errors</param>
+		void set_throwing(bool throwing);
+
+		/// <summary>
+		/// Check whether errors throw (see set_throwing).
+		/// </summary>
+		/// <returns>true if errors throw runtime_error</returns>
+		bool is_throwing() const;
+
+		/// <summary>
+		/// Check whether a read failed while the deserializer was not throwing.
+		/// </summary>
+		/// <returns>true if a read failed since the last restore()</returns>
+		bool has_failed() const;
+
+		/// <summary>
+		/// Runs <paramref name="parser"/> without exceptions, keeping what it read only if it succeeds.
+		/// <para>The parser fails if a read fails or if it returns false (parsers may also return nothing). On failure the cursor and the error state are restored, so trying several candidate formats only costs the reads actually done.</para>
+		/// </summary>
+		/// <typeparam name="Parser">Callable taking a Deserializer&amp; and returning bool or void</typeparam>
+		/// <param name="parser">Reads from this deserializer</param>
+		/// <returns>true if the parser succeeded</returns>
+		template <typename Parser>
+		bool try_parse(Parser parser)
+		{
+			const Checkpoint start = this->checkpoint();
+			const bool was_throwing = this->throwing;
+
+			this->throwing = false;
+			this->failed = false;
+
+			bool accepted = true;
+
+			try
+			{
+				if constexpr (std::is_same<decltype(parser(*this)), bool>::value)
+					accepted = parser(*this);
+				else
+					parser(*this);
+			}
+			catch (...)
+			{
+				this->throwing = was_throwing;
+				this->restore(start);
+				throw;
+			}
+
+			this->throwing = was_throwing;
+
+			if (!accepted || this->failed)
+			{
+				this->restore(start);
+				return false;
+			}
+
+			this->failed = start.failed;
+
+			return true;
+		}
+
 		/// <summary>
 		/// Print the internal buffer specifying the size and separating each byte using <paramref name="sep"/> character.
 		/// </summary>
@@ -128,17 +413,36 @@ namespace bufsd
 		/// <param name="buffer"></param>
 		Deserializer(const std::vector<unsigned char> &buffer);
 
+		/// <summary>
+		/// Constructs a new buffer deserializer that reads <paramref name="size"/> bytes starting at <paramref name="data"/> without copying them.
+		/// <para>The bytes are not owned by the deserializer, so they must outlive it (and every copy of it).</para>
+		/// </summary>
+		/// <param name="data">Pointer to the first byte of the buffer</param>
+		/// <param name="size">Amount of bytes of the buffer</param>
+		Deserializer(const unsigned char *data, size_t size);
+
+		Deserializer(const Deserializer &other);
+		Deserializer(Deserializer &&other) = default;
+		Deserializer &operator=(const Deserializer &other);
+		Deserializer &operator=(Deserializer &&other) = default;
+
 	private:
 		unsigned long long get_big_endian(size_t amount_of_bytes);
 		unsigned long long get_little_endian(size_t amount_of_bytes);
-		void assert_is_available(size_t amount_of_bytes) const;
+		bool check_available(size_t amount_of_bytes) const;
+		void fail(const std::string &message) const;
 		void update_remaining();
 
 	private:
 		std::vector<unsigned char> buffer;
+		const unsigned char *data = nullptr;
+		bool owns_buffer = true;
 
 		size_t cursor = 0;
 		size_t buffer_size = 0;
 		size_t remaining = 0;
+
+		bool throwing = true;
+		mutable bool failed = false;
 	};
 }
\ No newline at end of file
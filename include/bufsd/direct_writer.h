@@ -0,0 +1,191 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <condition_variable>
+
+#include "bufsd/utils.h"
+#include "bufsd/framing.h"
+#include "bufsd/serializer.h"
+
+namespace bufsd
+{
+	struct Direct_Writer_Options
+	{
+		/// <summary>
+		/// Size of each of the two staging buffers, rounded up to a multiple of alignment.
+		/// </summary>
+		size_t buffer_size = 4 * 1024 * 1024;
+
+		/// <summary>
+		/// Alignment of the buffers, of the file offsets and of the write sizes required by O_DIRECT.
+		/// </summary>
+		size_t alignment = 4096;
+
+		/// <summary>
+		/// Whether to bypass the page cache. Falls back to buffered writes if the file system refuses O_DIRECT.
+		/// </summary>
+		bool direct = true;
+
+		/// <summary>
+		/// Whether close() calls fdatasync after writing the tail and the patches.
+		/// </summary>
+		bool sync = true;
+	};
+
+	class Direct_Writer
+	{
+	public:
+		/// <summary>
+		/// Creates (or truncates) <paramref name="path"/> for large sequential writes that bypass the page cache (POSIX only, O_DIRECT where available).
+		/// <para>While a background thread writes one full staging buffer, the caller fills the other one.</para>
+		/// </summary>
+		/// <param name="path">Path of the file</param>
+		/// <param name="options">Buffer size, alignment and durability</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be opened or the buffers can't be allocated</exception>
+		Direct_Writer(const std::string &path, const Direct_Writer_Options &options = {});
+
+		/// <summary>
+		/// Closes the file, ignoring errors (call close() to handle them).
+		/// </summary>
+		~Direct_Writer();
+
+		Direct_Writer(const Direct_Writer &) = delete;
+		Direct_Writer &operator=(const Direct_Writer &) = delete;
+
+		/// <summary>
+		/// Copies bytes into the current staging buffer, handing it to the background thread when full.
+		/// </summary>
+		/// <param name="data">Pointer to the first byte</param>
+		/// <param name="size">Amount of bytes</param>
+		/// <exception cref="runtime_error">Occurs if a previous write failed or the writer is closed</exception>
+		/// <returns>Reference to the writer object (allows chaining methods)</returns>
+		Direct_Writer &write(const unsigned char *data, size_t size);
+
+		/// <summary>
+		/// Copies the buffer of <paramref name="serializer"/> into the staging buffers.
+		/// </summary>
+		/// <param name="serializer">Serializer holding the bytes</param>
+		/// <exception cref="runtime_error">Occurs if a previous write failed or the writer is closed</exception>
+		/// <returns>Reference to the writer object (allows chaining methods)</returns>
+		Direct_Writer &write(Serializer &serializer);
+
+		/// <summary>
+		/// Writes <paramref name="serializer"/> as a frame preceded by its length prefix.
+		/// </summary>
+		/// <param name="serializer">Serializer holding the frame</param>
+		/// <param name="prefix">Format of the length prefix</param>
+		/// <exception cref="runtime_error">Occurs if the frame doesn't fit in the prefix, a previous write failed or the writer is closed</exception>
+		/// <returns>Reference to the writer object (allows chaining methods)</returns>
+		Direct_Writer &write_frame(Serializer &serializer, const Length_Prefix &prefix = {});
+
+		/// <summary>
+		/// Writes <paramref name="amount_of_bytes"/> zero bytes to be filled later with patch(), e.g. a header holding the total size or a record count.
+		/// </summary>
+		/// <param name="amount_of_bytes">Amount of placeholder bytes</param>
+		/// <exception cref="runtime_error">Occurs if a previous write failed or the writer is closed</exception>
+		/// <returns>File offset of the first placeholder byte</returns>
+		unsigned long long write_placeholder(size_t amount_of_bytes);
+
+		/// <summary>
+		/// Overwrites bytes already written. Patches still in the current staging buffer are applied in place, the others are written by close() through a buffered pwrite.
+		/// </summary>
+		/// <param name="offset">File offset of the first byte to overwrite</param>
+		/// <param name="data">Pointer to the new bytes</param>
+		/// <param name="size">Amount of bytes</param>
+		/// <exception cref="runtime_error">Occurs if the bytes go beyond what was written or the writer is closed</exception>
+		/// <returns>Reference to the writer object (allows chaining methods)</returns>
+		Direct_Writer &patch(unsigned long long offset, const unsigned char *data, size_t size);
+
+		/// <summary>
+		/// Overwrites sizeof(T) bytes at <paramref name="offset"/> with <paramref name="value"/> in Big-Endian.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, used to know how many bytes will be written</typeparam>
+		/// <param name="offset">File offset of the first byte to overwrite</param>
+		/// <param name="value">Value to be written</param>
+		/// <exception cref="runtime_error">Occurs if the bytes go beyond what was written or the writer is closed</exception>
+		/// <returns>Reference to the writer object (allows chaining methods)</returns>
+		template <typename T>
+		Direct_Writer &patch_big_endian(unsigned long long offset, T value)
+		{
+			unsigned char bytes[sizeof(T)];
+			write_integer(bytes, (unsigned long long)value, sizeof(T), Endianness::BIG);
+			return this->patch(offset, bytes, sizeof(T));
+		}
+
+		/// <summary>
+		/// Overwrites sizeof(T) bytes at <paramref name="offset"/> with <paramref name="value"/> in Little-Endian.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, used to know how many bytes will be written</typeparam>
+		/// <param name="offset">File offset of the first byte to overwrite</param>
+		/// <param name="value">Value to be written</param>
+		/// <exception cref="runtime_error">Occurs if the bytes go beyond what was written or the writer is closed</exception>
+		/// <returns>Reference to the writer object (allows chaining methods)</returns>
+		template <typename T>
+		Direct_Writer &patch_little_endian(unsigned long long offset, T value)
+		{
+			unsigned char bytes[sizeof(T)];
+			write_integer(bytes, (unsigned long long)value, sizeof(T), Endianness::LITTLE);
+			return this->patch(offset, bytes, sizeof(T));
+		}
+
+		/// <summary>
+		/// Writes the unaligned tail and the pending patches, trims the padding of the last block and closes the file.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if a write, truncate or sync fails</exception>
+		void close();
+
+		/// <summary>
+		/// Get the amount of bytes written so far.
+		/// </summary>
+		/// <returns>Size of the file once closed</returns>
+		unsigned long long get_size() const;
+
+		/// <summary>
+		/// Check whether the page cache is bypassed, i.e. O_DIRECT was accepted by the file system.
+		/// </summary>
+		/// <returns>true if writes use O_DIRECT</returns>
+		bool is_direct() const;
+
+	private:
+		struct Pending_Patch
+		{
+			unsigned long long offset;
+			std::vector<unsigned char> bytes;
+		};
+
+		std::string path;
+		int fd = -1;
+		std::atomic<bool> direct{false};
+		bool sync;
+		size_t alignment;
+		size_t buffer_size;
+
+		unsigned char *buffers[2] = {nullptr, nullptr};
+		size_t current = 0;
+		size_t fill = 0;
+		unsigned long long buffer_offset = 0;
+		std::vector<Pending_Patch> patches;
+
+		std::mutex mutex;
+		std::condition_variable wake_writer;
+		std::condition_variable buffer_written;
+		std::thread writer;
+		bool stopping = false;
+		bool has_queued = false;
+		size_t queued_buffer = 0;
+		size_t queued_size = 0;
+		unsigned long long queued_offset = 0;
+		std::string error;
+
+		void hand_over();
+		void wait_idle();
+		void run_writer();
+		bool write_at(const unsigned char *data, size_t size, unsigned long long offset, std::string &failure);
+		void assert_open() const;
+	};
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <climits>
+#include <cstdint>
+
+#include "bufsd/framing.h"
+#include "bufsd/frame_index.h"
+
+namespace bufsd
+{
+	class Frame_Forwarder
+	{
+	public:
+		/// <summary>
+		/// Opens a stream of length-prefixed frames stored in <paramref name="path"/> to forward it to sockets or pipes without copying payloads into userspace (POSIX only, sendfile and splice on Linux).
+		/// </summary>
+		/// <param name="path">Path of the stream file</param>
+		/// <param name="prefix">Format of the length prefix</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be opened or the prefix width is not between 1 and 8</exception>
+		Frame_Forwarder(const std::string &path, const Length_Prefix &prefix = {});
+		~Frame_Forwarder();
+
+		Frame_Forwarder(const Frame_Forwarder &) = delete;
+		Frame_Forwarder &operator=(const Frame_Forwarder &) = delete;
+
+		/// <summary>
+		/// Forwards whole frames (prefixes included) from the current position, reading only their length prefixes to find where they end, then moving the whole extent in the kernel.
+		/// <para>A frame still being appended to the file is left for a later call. Blocks while a non-blocking <paramref name="destination"/> is full.</para>
+		/// <para>If the transfer fails, the current position is left after the last byte that reached the destination, so a retry doesn't send anything twice.</para>
+		/// </summary>
+		/// <param name="destination">Socket, pipe or file receiving the frames</param>
+		/// <param name="max_frames">Maximum amount of frames to forward</param>
+		/// <param name="max_bytes">Maximum amount of bytes to forward, exceeded only to forward at least one frame</param>
+		/// <exception cref="runtime_error">Occurs if reading a prefix or the transfer fails</exception>
+		/// <returns>Amount of frames forwarded</returns>
+		size_t forward(int destination, size_t max_frames = SIZE_MAX, unsigned long long max_bytes = ULLONG_MAX);
+
+		/// <summary>
+		/// Forwards the frames [<paramref name="first_frame"/>, <paramref name="first_frame"/> + <paramref name="frame_count"/>) located with <paramref name="index"/>, so not even the prefixes are read, and moves the current position after them.
+		/// <para>If the transfer fails, the current position is left after the last byte that reached the destination.</para>
+		/// </summary>
+		/// <param name="destination">Socket, pipe or file receiving the frames</param>
+		/// <param name="index">Index of the stream file</param>
+		/// <param name="first_frame">Index of the first frame to forward</param>
+		/// <param name="frame_count">Amount of frames to forward</param>
+		/// <exception cref="runtime_error">Occurs if a frame doesn't exist or the transfer fails</exception>
+		/// <returns>Amount of bytes forwarded</returns>
+		unsigned long long forward(int destination, const Frame_Index &index, size_t first_frame, size_t frame_count);
+
+		/// <summary>
+		/// Moves the current position, which must be the start of a frame.
+		/// </summary>
+		/// <param name="offset">Offset of a length prefix in the file</param>
+		void seek(unsigned long long offset);
+
+		/// <summary>
+		/// Get the offset of the next frame to forward.
+		/// </summary>
+		/// <returns>Current position</returns>
+		unsigned long long get_position() const;
+
+	private:
+		std::string path;
+		int fd = -1;
+		Length_Prefix prefix;
+		unsigned long long position = 0;
+		int pipe_fds[2] = {-1, -1};
+
+		unsigned long long get_file_size() const;
+		void transfer(int destination, unsigned long long size);
+		void splice_transfer(int destination, unsigned long long size);
+		void splice_through_pipe(int destination, unsigned long long offset, unsigned long long size);
+		void copy_transfer(int destination, unsigned long long size);
+		void write_all(int destination, const unsigned char *data, size_t size);
+	};
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+#include "bufsd/framing.h"
+
+namespace bufsd
+{
+	struct Frame_Shard
+	{
+		size_t first_frame;
+		size_t frame_count;
+		unsigned long long offset;
+		unsigned long long size;
+	};
+
+	class Frame_Index
+	{
+	public:
+		/// <summary>
+		/// Scans the length-prefixed stream at <paramref name="stream_path"/>, reading only the length prefixes.
+		/// <para>Payloads are skipped without being read. A truncated frame at the end of the stream is not indexed.</para>
+		/// </summary>
+		/// <param name="stream_path">Path of the framed stream</param>
+		/// <param name="prefix">Format of the length prefix</param>
+		/// <exception cref="runtime_error">Occurs if the stream can't be read or the prefix width is not between 1 and 8</exception>
+		/// <returns>The index of the stream</returns>
+		static Frame_Index build(const std::string &stream_path, const Length_Prefix &prefix = {});
+
+		/// <summary>
+		/// Scans a length-prefixed stream held in memory.
+		/// </summary>
+		/// <param name="data">Pointer to the first byte of the stream</param>
+		/// <param name="size">Size of the stream</param>
+		/// <param name="prefix">Format of the length prefix</param>
+		/// <exception cref="runtime_error">Occurs if the prefix width is not between 1 and 8</exception>
+		/// <returns>The index of the stream</returns>
+		static Frame_Index build(const unsigned char *data, size_t size, const Length_Prefix &prefix = {});
+
+		/// <summary>
+		/// Loads an index saved with save().
+		/// </summary>
+		/// <param name="index_path">Path of the sidecar index file</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be read or is not a valid index</exception>
+		/// <returns>The loaded index</returns>
+		static Frame_Index load(const std::string &index_path);
+
+		/// <summary>
+		/// Saves the index as a sidecar file: the frame sizes are delta-encoded as variable-length integers and protected by a CRC-32C.
+		/// </summary>
+		/// <param name="index_path">Path of the sidecar index file</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be written</exception>
+		void save(const std::string &index_path) const;
+
+		/// <summary>
+		/// Get the amount of complete frames in the stream.
+		/// </summary>
+		/// <returns>Amount of frames</returns>
+		size_t get_frame_count() const;
+
+		/// <summary>
+		/// Get the offset of the length prefix of <paramref name="frame"/> in O(1).
+		/// </summary>
+		/// <param name="frame">Index of the frame, starting from 0</param>
+		/// <exception cref="runtime_error">Occurs if the frame doesn't exist</exception>
+		/// <returns>Offset of the frame</returns>
+		unsigned long long get_offset(size_t frame) const;
+
+		/// <summary>
+		/// Get the size of <paramref name="frame"/>, including its length prefix.
+		/// </summary>
+		/// <param name="frame">Index of the frame, starting from 0</param>
+		/// <exception cref="runtime_error">Occurs if the frame doesn't exist</exception>
+		/// <returns>Size of the frame</returns>
+		unsigned long long get_frame_size(size_t frame) const;
+
+		/// <summary>
+		/// Get the offset right after the last complete frame.
+		/// </summary>
+		/// <returns>Size of the indexed part of the stream</returns>
+		unsigned long long get_indexed_size() const;
+
+		/// <summary>
+		/// Get the length prefix format of the indexed stream.
+		/// </summary>
+		/// <returns>Length prefix format</returns>
+		const Length_Prefix &get_prefix() const;
+
+		/// <summary>
+		/// Splits the frames into <paramref name="amount_of_shards"/> contiguous shards with the same amount of frames (the first shards get one extra frame when it doesn't divide evenly).
+		/// </summary>
+		/// <param name="amount_of_shards">Amount of shards wanted</param>
+		/// <returns>The non-empty shards, in stream order</returns>
+		std::vector<Frame_Shard> split(size_t amount_of_shards) const;
+
+	private:
+		void assert_frame_exists(size_t frame) const;
+
+	private:
+		Length_Prefix prefix;
+		std::vector<unsigned long long> offsets{0};
+	};
+}
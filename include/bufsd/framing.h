@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "bufsd/utils.h"
+
+namespace bufsd
+{
+	/// <summary>
+	/// Describes the length prefix placed before each record of a framed stream.
+	/// <para>The prefix holds the size of the record that follows it, not counting the prefix itself.</para>
+	/// </summary>
+	struct Length_Prefix
+	{
+		unsigned char number_of_bytes = 4;
+		Endianness endianness = Endianness::BIG;
+
+		/// <summary>
+		/// Checks that number_of_bytes is one of the widths read and write support.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if number_of_bytes is not between 1 and 8</exception>
+		void validate() const
+		{
+			if (this->number_of_bytes < 1 || this->number_of_bytes > 8)
+				throw std::runtime_error("Length prefix width must be between 1 and 8 bytes, but " + std::to_string(this->number_of_bytes) + " was given");
+		}
+
+		/// <summary>
+		/// Reads a length prefix from <paramref name="source"/>.
+		/// </summary>
+		/// <param name="source">Where the prefix starts (must have number_of_bytes bytes available)</param>
+		/// <returns>The size of the record that follows the prefix</returns>
+		size_t read(const unsigned char *source) const
+		{
+			return (size_t)read_integer(source, this->number_of_bytes, this->endianness);
+		}
+
+		/// <summary>
+		/// Checks whether a prefix announcing <paramref name="size"/> bytes and the record that follows it fit in <paramref name="remaining"/> bytes.
+		/// <para>Compares without adding the prefix size to <paramref name="size"/>, so a forged 8 bytes prefix can't wrap around.</para>
+		/// </summary>
+		/// <param name="size">Record size read from the prefix</param>
+		/// <param name="remaining">Bytes available from the start of the prefix</param>
+		/// <returns>true if the whole frame is available</returns>
+		bool fits(unsigned long long size, unsigned long long remaining) const
+		{
+			return remaining >= this->number_of_bytes && size <= remaining - this->number_of_bytes;
+		}
+
+		/// <summary>
+		/// Writes a length prefix for a record of <paramref name="size"/> bytes to <paramref name="destination"/>.
+		/// </summary>
+		/// <param name="destination">Where the prefix will be written (must have room for number_of_bytes bytes)</param>
+		/// <param name="size">Size of the record</param>
+		/// <exception cref="runtime_error">Occurs if <paramref name="size"/> doesn't fit in the prefix or the prefix width is invalid</exception>
+		void write(unsigned char *destination, size_t size) const
+		{
+			// Callers write into 8 bytes buffers, so the width is checked before anything is written
+			this->validate();
+
+			if (this->number_of_bytes < 8 && (unsigned long long)size >> (this->number_of_bytes * 8) != 0)
+				throw std::runtime_error("Record of " + std::to_string(size) + " byte(s) doesn't fit in a " + std::to_string(this->number_of_bytes) + " byte(s) length prefix");
+
+			write_integer(destination, size, this->number_of_bytes, this->endianness);
+		}
+	};
+}
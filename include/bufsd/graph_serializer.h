@@ -0,0 +1,188 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <typeinfo>
+#include <typeindex>
+#include <functional>
+#include <unordered_map>
+
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	/// <summary>
+	/// Tag written before each shared reference of an object graph.
+	/// </summary>
+	enum class Graph_Tag : unsigned char
+	{
+		NULL_REFERENCE = 0,
+		NEW_OBJECT = 1,
+		BACK_REFERENCE = 2
+	};
+
+	class Graph_Serializer
+	{
+	public:
+		/// <summary>
+		/// Constructs a graph writer pushing to <paramref name="serializer"/>, which must outlive it.
+		/// <para>Objects shared by several references are written once: the first reference writes the object and gets the next ID (0, 1, 2...), the following ones only write that ID.</para>
+		/// <para>Written objects are identified by address and type, and are kept alive by the graph writer until it is destroyed.</para>
+		/// </summary>
+		/// <param name="serializer">Buffer maker receiving the graph</param>
+		Graph_Serializer(Serializer &serializer);
+
+		/// <summary>
+		/// Pushes a shared reference, writing the object with its serialize() method only the first time it is seen.
+		/// </summary>
+		/// <typeparam name="T">Serializable type of the object</typeparam>
+		/// <param name="object">Reference to push, may be null</param>
+		/// <returns>Reference to the graph writer object (allows chaining methods)</returns>
+		template <typename T>
+		Graph_Serializer &push_shared(const std::shared_ptr<T> &object)
+		{
+			return this->push_shared(object, [](Graph_Serializer &graph, const T &value)
+									 { graph.get_serializer().push_object(value); });
+		}
+
+		/// <summary>
+		/// Pushes a shared reference, writing the object with <paramref name="encoder"/> only the first time it is seen.
+		/// <para>The encoder gets this graph writer, so objects holding shared references themselves push them with push_shared. The object is registered before being encoded, so cycles become back-references.</para>
+		/// </summary>
+		/// <typeparam name="T">Type of the object</typeparam>
+		/// <typeparam name="Encoder">Callable taking a Graph_Serializer&amp; and a const T&amp;</typeparam>
+		/// <param name="object">Reference to push, may be null</param>
+		/// <param name="encoder">Writes the fields of the object</param>
+		/// <returns>Reference to the graph writer object (allows chaining methods)</returns>
+		template <typename T, typename Encoder>
+		Graph_Serializer &push_shared(const std::shared_ptr<T> &object, Encoder encoder)
+		{
+			if (this->push_reference(object, typeid(T)))
+				encoder(*this, *object);
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Get the buffer maker receiving the graph, to push plain fields between references.
+		/// </summary>
+		/// <returns>Buffer maker of the graph</returns>
+		Serializer &get_serializer();
+
+		/// <summary>
+		/// Get the amount of distinct objects written so far.
+		/// </summary>
+		/// <returns>Amount of objects</returns>
+		size_t get_object_count() const;
+
+	private:
+		// An object and its first member share their address, so the type is part of the identity
+		struct Object_Key
+		{
+			const void *address;
+			std::type_index type;
+
+			bool operator==(const Object_Key &other) const
+			{
+				return this->address == other.address && this->type == other.type;
+			}
+		};
+
+		struct Object_Key_Hash
+		{
+			size_t operator()(const Object_Key &key) const
+			{
+				return std::hash<const void *>()(key.address) ^ key.type.hash_code();
+			}
+		};
+
+		// Written objects are kept alive, so a freed address can't be reused by a new object that would alias it
+		struct Written_Object
+		{
+			unsigned int id;
+			std::shared_ptr<const void> object;
+		};
+
+		Serializer &serializer;
+		std::unordered_map<Object_Key, Written_Object, Object_Key_Hash> ids;
+
+		bool push_reference(const std::shared_ptr<const void> &object, const std::type_info &type);
+	};
+
+	class Graph_Deserializer
+	{
+	public:
+		/// <summary>
+		/// Constructs a graph reader over <paramref name="deserializer"/>, which must outlive it.
+		/// </summary>
+		/// <param name="deserializer">Deserializer holding a graph written by Graph_Serializer</param>
+		Graph_Deserializer(Deserializer &deserializer);
+
+		/// <summary>
+		/// Get the next shared reference, creating the object with fill_from_bytes the first time it appears, so references to the same object share it again.
+		/// </summary>
+		/// <typeparam name="T">Deserializable type of the object</typeparam>
+		/// <exception cref="runtime_error">Occurs when the tag or the back-reference is invalid, or refers to an object of another type</exception>
+		/// <returns>Shared reference, null if a null reference was pushed</returns>
+		template <typename T>
+		std::shared_ptr<T> get_shared()
+		{
+			return this->get_shared<T>([](Graph_Deserializer &graph, T &value)
+									   { value.fill_from_bytes(graph.get_deserializer()); });
+		}
+
+		/// <summary>
+		/// Get the next shared reference, filling new objects with <paramref name="decoder"/>.
+		/// <para>New objects are default constructed and registered before being decoded, so back-references inside them (cycles) resolve to the object being decoded.</para>
+		/// </summary>
+		/// <typeparam name="T">Default constructible type of the object</typeparam>
+		/// <typeparam name="Decoder">Callable taking a Graph_Deserializer&amp; and a T&amp;</typeparam>
+		/// <param name="decoder">Reads the fields of the object</param>
+		/// <exception cref="runtime_error">Occurs when the tag or the back-reference is invalid, or refers to an object of another type</exception>
+		/// <returns>Shared reference, null if a null reference was pushed</returns>
+		template <typename T, typename Decoder>
+		std::shared_ptr<T> get_shared(Decoder decoder)
+		{
+			Graph_Tag tag = this->get_tag();
+
+			if (tag == Graph_Tag::NULL_REFERENCE)
+				return nullptr;
+
+			if (tag == Graph_Tag::BACK_REFERENCE)
+				return std::static_pointer_cast<T>(this->get_back_reference(typeid(T)));
+
+			std::shared_ptr<T> object = std::make_shared<T>();
+			this->objects.push_back({object, &typeid(T)});
+
+			decoder(*this, *object);
+
+			return object;
+		}
+
+		/// <summary>
+		/// Get the deserializer holding the graph, to read plain fields between references.
+		/// </summary>
+		/// <returns>Deserializer of the graph</returns>
+		Deserializer &get_deserializer();
+
+		/// <summary>
+		/// Get the amount of distinct objects read so far.
+		/// </summary>
+		/// <returns>Amount of objects</returns>
+		size_t get_object_count() const;
+
+	private:
+		struct Entry
+		{
+			std::shared_ptr<void> object;
+			const std::type_info *type;
+		};
+
+		Deserializer &deserializer;
+		std::vector<Entry> objects;
+
+		Graph_Tag get_tag();
+		std::shared_ptr<void> get_back_reference(const std::type_info &type);
+	};
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+namespace bufsd
+{
+	/// <summary>
+	/// Sort direction of a field inside an order-preserving key.
+	/// </summary>
+	enum class Key_Order
+	{
+		ASCENDING,
+		DESCENDING
+	};
+
+	/// <summary>
+	/// Maps <paramref name="value"/> to an unsigned integer whose Big-Endian bytes compare (with memcmp) in the same order as the values.
+	/// <para>Unsigned values are kept as is, signed values get the sign bit flipped and floating point values get the sign bit flipped when positive or every bit flipped when negative (-0.0 is mapped as 0.0).</para>
+	/// </summary>
+	/// <typeparam name="T">Arithmetic type of the value</typeparam>
+	/// <param name="value">Value to be mapped</param>
+	/// <returns>The order-preserving bits, using the sizeof(T) lowest bytes</returns>
+	template <typename T>
+	unsigned long long to_key_bits(T value)
+	{
+		static_assert(std::is_arithmetic<T>::value, "Only arithmetic values can be encoded as keys");
+		static_assert(sizeof(T) <= 8, "Keys are limited to 8 bytes values");
+
+		const unsigned long long sign_bit = 1ull << (sizeof(T) * 8 - 1);
+
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only 4 and 8 bytes floating point values can be encoded as keys");
+			using Bits = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+
+			if (value == 0)
+				value = 0;
+
+			Bits bits;
+			std::memcpy(&bits, &value, sizeof(T));
+
+			unsigned long long key = bits;
+			return (key & sign_bit) ? ~key & (sign_bit | (sign_bit - 1)) : key | sign_bit;
+		}
+		else if constexpr (std::is_signed<T>::value)
+		{
+			unsigned long long key = (unsigned long long)value & (sign_bit | (sign_bit - 1));
+			return key ^ sign_bit;
+		}
+		else
+		{
+			return (unsigned long long)value;
+		}
+	}
+
+	/// <summary>
+	/// Inverse of to_key_bits, rebuilds the value from its order-preserving bits.
+	/// </summary>
+	/// <typeparam name="T">Arithmetic type of the value</typeparam>
+	/// <param name="key">The order-preserving bits</param>
+	/// <returns>The original value</returns>
+	template <typename T>
+	T from_key_bits(unsigned long long key)
+	{
+		static_assert(std::is_arithmetic<T>::value, "Only arithmetic values can be decoded from keys");
+		static_assert(sizeof(T) <= 8, "Keys are limited to 8 bytes values");
+
+		const unsigned long long sign_bit = 1ull << (sizeof(T) * 8 - 1);
+		const unsigned long long mask = sign_bit | (sign_bit - 1);
+
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			using Bits = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+
+			Bits bits = (Bits)((key & sign_bit) ? key ^ sign_bit : ~key & mask);
+
+			T value;
+			std::memcpy(&value, &bits, sizeof(T));
+			return value;
+		}
+		else if constexpr (std::is_same<T, bool>::value)
+		{
+			// Descending keys arrive with every bit of the byte complemented, so only the lowest bit is meaningful
+			return (key & 1) != 0;
+		}
+		else if constexpr (std::is_signed<T>::value)
+		{
+			return (T)((key ^ sign_bit) & mask);
+		}
+		else
+		{
+			return (T)(key & mask);
+		}
+	}
+}
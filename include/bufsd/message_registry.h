@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+#include "bufsd/utils.h"
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	using Message_Handler = std::function<void(Deserializer &frame)>;
+
+	class Message_Registry
+	{
+	public:
+		/// <summary>
+		/// Constructs an empty registry dispatching frames by a type ID stored at a fixed place.
+		/// </summary>
+		/// <param name="id_size">Amount of bytes of the type ID (1 to 8)</param>
+		/// <param name="endianness">Byte order of the type ID</param>
+		/// <param name="id_offset">Distance from the cursor of the frame to the type ID</param>
+		/// <exception cref="runtime_error">Occurs if <paramref name="id_size"/> is not between 1 and 8</exception>
+		Message_Registry(unsigned char id_size = 2, Endianness endianness = Endianness::BIG, size_t id_offset = 0);
+
+		/// <summary>
+		/// Registers <paramref name="handler"/> for frames of type <paramref name="type_id"/>. The handler gets the frame with the cursor still before the type ID.
+		/// </summary>
+		/// <param name="type_id">Type ID of the frames</param>
+		/// <param name="handler">Called with each frame of that type</param>
+		/// <exception cref="runtime_error">Occurs if the type ID is already registered or doesn't fit in id_size bytes</exception>
+		/// <returns>Reference to the registry object (allows chaining methods)</returns>
+		Message_Registry &add(unsigned long long type_id, const Message_Handler &handler);
+
+		/// <summary>
+		/// Registers a decoder creating a <typeparamref name="T"/> with T::from_bytes for frames of type <paramref name="type_id"/>.
+		/// </summary>
+		/// <typeparam name="T">Deserializable type of the frames, whose fill_from_bytes reads the type ID too</typeparam>
+		/// <typeparam name="Consumer">Callable taking a T&amp;</typeparam>
+		/// <param name="type_id">Type ID of the frames</param>
+		/// <param name="consumer">Called with each decoded object</param>
+		/// <exception cref="runtime_error">Occurs if the type ID is already registered or doesn't fit in id_size bytes</exception>
+		/// <returns>Reference to the registry object (allows chaining methods)</returns>
+		template <typename T, typename Consumer>
+		Message_Registry &add(unsigned long long type_id, Consumer consumer)
+		{
+			return this->add(type_id, [consumer](Deserializer &frame)
+							 {
+								 T object = T::from_bytes(frame);
+								 consumer(object);
+							 });
+		}
+
+		/// <summary>
+		/// Builds the perfect hash table of the registered type IDs. Must be called again after adding types.
+		/// <para>Uses hash and displace: IDs are spread into small buckets, and each bucket gets a seed sending all its IDs to free slots.</para>
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if no perfect hash is found (never expected in practice)</exception>
+		void build();
+
+		/// <summary>
+		/// Peeks the type ID of <paramref name="frame"/> and calls its handler, costing two hashes and one indirect call whatever the amount of types.
+		/// </summary>
+		/// <param name="frame">Frame with the cursor before its type ID (id_offset bytes before)</param>
+		/// <exception cref="runtime_error">Occurs if the registry isn't built or the frame is too short to hold a type ID</exception>
+		/// <returns>false if the type ID is not registered</returns>
+		bool dispatch(Deserializer &frame) const;
+
+		/// <summary>
+		/// Check whether <paramref name="type_id"/> is registered (and built).
+		/// </summary>
+		/// <param name="type_id">Type ID to look for</param>
+		/// <returns>true if a handler is registered</returns>
+		bool contains(unsigned long long type_id) const;
+
+		/// <summary>
+		/// Get the amount of registered types.
+		/// </summary>
+		/// <returns>Amount of types</returns>
+		size_t get_type_count() const;
+
+	private:
+		struct Entry
+		{
+			unsigned long long type_id;
+			Message_Handler handler;
+		};
+
+		unsigned char id_size;
+		Endianness endianness;
+		size_t id_offset;
+
+		std::vector<Entry> entries;
+		bool built = false;
+
+		std::vector<unsigned int> seeds;
+		// Indexes into entries rather than pointers, so copies of the registry stay valid
+		std::vector<unsigned int> slots;
+		size_t bucket_mask = 0;
+		size_t slot_mask = 0;
+
+		size_t find_slot(unsigned long long type_id) const;
+	};
+}
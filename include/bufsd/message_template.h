@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+
+#include "bufsd/utils.h"
+
+namespace bufsd
+{
+	class Message_Template
+	{
+	public:
+		/// <summary>
+		/// Handle of a patch point, returned by add_slot() and used on every send instead of the name.
+		/// </summary>
+		using Slot = size_t;
+
+		/// <summary>
+		/// Constructs a template from an already encoded message, usually the buffer of a Serializer where the changing fields were pushed with push_placeholder().
+		/// </summary>
+		/// <param name="bytes">Encoded message, copied by the template</param>
+		Message_Template(const std::vector<unsigned char> &bytes);
+
+		/// <summary>
+		/// Declares the bytes [<paramref name="position"/>, <paramref name="position"/> + <paramref name="number_of_bytes"/>) as a named patch point.
+		/// </summary>
+		/// <param name="name">Name of the patch point, unique in the template</param>
+		/// <param name="position">Offset of the first byte of the field in the message</param>
+		/// <param name="number_of_bytes">Width of the field (1 to 8 bytes to be patched with integers, any width for patch_buffer)</param>
+		/// <param name="endianness">Byte order of the field when patched with integers</param>
+		/// <exception cref="runtime_error">Occurs if the name is already used or the field goes beyond the end of the message</exception>
+		/// <returns>Handle of the patch point</returns>
+		Slot add_slot(const std::string &name, size_t position, size_t number_of_bytes, Endianness endianness = Endianness::BIG);
+
+		/// <summary>
+		/// Get the handle of the patch point called <paramref name="name"/>. Meant for setup, since it compares names.
+		/// </summary>
+		/// <param name="name">Name of the patch point</param>
+		/// <exception cref="runtime_error">Occurs if there is no patch point with this name</exception>
+		/// <returns>Handle of the patch point</returns>
+		Slot find_slot(const std::string &name) const;
+
+		/// <summary>
+		/// Copies the template message to <paramref name="destination"/>, which must have room for get_size() bytes.
+		/// </summary>
+		/// <param name="destination">Where the message is written, such as a slot of an output ring</param>
+		/// <returns>Reference to the template object (allows chaining patches)</returns>
+		const Message_Template &copy_to(unsigned char *destination) const
+		{
+			std::memcpy(destination, this->bytes.data(), this->bytes.size());
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Replaces the content of <paramref name="destination"/> with the template message, keeping its capacity.
+		/// </summary>
+		/// <param name="destination">Vector receiving the message</param>
+		/// <returns>Reference to the template object (allows chaining patches)</returns>
+		const Message_Template &copy_to(std::vector<unsigned char> &destination) const
+		{
+			destination.assign(this->bytes.begin(), this->bytes.end());
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Writes <paramref name="value"/> to the patch point <paramref name="slot"/> of a message copied with copy_to().
+		/// <para>Nothing is checked on this path: the slot must come from this template and be 1 to 8 bytes wide.</para>
+		/// </summary>
+		/// <param name="destination">First byte of the copied message</param>
+		/// <param name="slot">Handle of the patch point</param>
+		/// <param name="value">Value to be written, truncated to the width of the slot</param>
+		/// <returns>Reference to the template object (allows chaining patches)</returns>
+		const Message_Template &patch(unsigned char *destination, Slot slot, unsigned long long value) const
+		{
+			const Patch_Point &point = this->slots[slot];
+			write_integer(destination + point.position, value, point.number_of_bytes, point.endianness);
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Writes <paramref name="value"/> to the patch point <paramref name="slot"/> of a message copied with copy_to().
+		/// </summary>
+		/// <param name="destination">Vector holding the copied message</param>
+		/// <param name="slot">Handle of the patch point</param>
+		/// <param name="value">Value to be written, truncated to the width of the slot</param>
+		/// <returns>Reference to the template object (allows chaining patches)</returns>
+		const Message_Template &patch(std::vector<unsigned char> &destination, Slot slot, unsigned long long value) const
+		{
+			return this->patch(destination.data(), slot, value);
+		}
+
+		/// <summary>
+		/// Writes the bytes of <paramref name="data"/> to the patch point <paramref name="slot"/> of a message copied with copy_to(), padding with zeros if <paramref name="size"/> is shorter than the slot.
+		/// </summary>
+		/// <param name="destination">First byte of the copied message</param>
+		/// <param name="slot">Handle of the patch point</param>
+		/// <param name="data">Bytes to be written</param>
+		/// <param name="size">Amount of bytes to write</param>
+		/// <exception cref="runtime_error">Occurs if <paramref name="size"/> is larger than the slot</exception>
+		/// <returns>Reference to the template object (allows chaining patches)</returns>
+		const Message_Template &patch_buffer(unsigned char *destination, Slot slot, const unsigned char *data, size_t size) const;
+
+		/// <summary>
+		/// Get the size of the template message.
+		/// </summary>
+		/// <returns>Amount of bytes written by copy_to()</returns>
+		size_t get_size() const
+		{
+			return this->bytes.size();
+		}
+
+		/// <summary>
+		/// Get the template message, with the values the patch points had when it was built.
+		/// </summary>
+		/// <returns>Vector with the template message</returns>
+		const std::vector<unsigned char> &get_bytes() const;
+
+	private:
+		struct Patch_Point
+		{
+			std::string name;
+			size_t position;
+			size_t number_of_bytes;
+			Endianness endianness;
+		};
+
+		std::vector<unsigned char> bytes;
+		std::vector<Patch_Point> slots;
+	};
+}
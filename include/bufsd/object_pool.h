@@ -0,0 +1,155 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	/// <summary>
+	/// Recycles Deserializable objects so decoding refills existing instances instead of creating new ones.
+	/// <para>Released objects keep their strings and vectors, so once fill_from_bytes reads into them with the capacity-keeping Deserializer overloads, decoding stops allocating.</para>
+	/// <para>Not thread-safe: use one pool per thread. Handles must not outlive their pool.</para>
+	/// </summary>
+	/// <typeparam name="T">Deserializable type, default constructible, whose fill_from_bytes overwrites every field</typeparam>
+	template <typename T>
+	class Object_Pool
+	{
+		struct Recycler
+		{
+			Object_Pool *pool;
+
+			void operator()(T *object) const
+			{
+				this->pool->recycle(object);
+			}
+		};
+
+	public:
+		/// <summary>
+		/// Owning handle giving its object back to the pool when destroyed.
+		/// </summary>
+		using Handle = std::unique_ptr<T, Recycler>;
+
+		/// <summary>
+		/// Constructs an empty pool.
+		/// </summary>
+		/// <param name="max_idle">Maximum amount of released objects kept for reuse, the others are deleted</param>
+		explicit Object_Pool(size_t max_idle = 64)
+			: max_idle(max_idle)
+		{
+		}
+
+		Object_Pool(const Object_Pool &) = delete;
+		Object_Pool &operator=(const Object_Pool &) = delete;
+
+		/// <summary>
+		/// Get an object, recycled if one is idle. A recycled object still holds the values it was released with.
+		/// </summary>
+		/// <returns>Handle to the object</returns>
+		Handle acquire()
+		{
+			if (this->idle.empty())
+			{
+				this->created++;
+
+				return Handle(new T{}, Recycler{this});
+			}
+
+			T *object = this->idle.back().release();
+			this->idle.pop_back();
+
+			return Handle(object, Recycler{this});
+		}
+
+		/// <summary>
+		/// Get an object filled with deserializer's bytes, like T::from_bytes but reusing an idle object.
+		/// <para>Since it uses the deserializer's buffer, it moves the cursor forward.</para>
+		/// </summary>
+		/// <param name="deserializer">The deserializer contaning the bytes that will be used</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes left in the buffer (the object goes back to the pool)</exception>
+		/// <returns>Handle to the filled object</returns>
+		Handle from_bytes(Deserializer &deserializer)
+		{
+			Handle object = this->acquire();
+			object->fill_from_bytes(deserializer);
+
+			return object;
+		}
+
+		/// <summary>
+		/// Get an object filled with a vector of bytes, like T::from_bytes but reusing an idle object.
+		/// </summary>
+		/// <param name="buffer">The bytes to deserialize</param>
+		/// <exception cref="runtime_error">Occurs when there is not enough bytes in the buffer (the object goes back to the pool)</exception>
+		/// <returns>Handle to the filled object</returns>
+		Handle from_bytes(const std::vector<unsigned char> &buffer)
+		{
+			Deserializer deserializer{buffer};
+
+			return this->from_bytes(deserializer);
+		}
+
+		/// <summary>
+		/// Creates idle objects until <paramref name="count"/> are available, so the first messages don't allocate either.
+		/// </summary>
+		/// <param name="count">Amount of idle objects wanted (capped by max_idle)</param>
+		void reserve(size_t count)
+		{
+			if (count > this->max_idle)
+				count = this->max_idle;
+
+			this->idle.reserve(this->max_idle);
+
+			while (this->idle.size() < count)
+			{
+				this->idle.emplace_back(new T{});
+				this->created++;
+			}
+		}
+
+		/// <summary>
+		/// Get the amount of objects waiting for reuse.
+		/// </summary>
+		/// <returns>Amount of idle objects</returns>
+		size_t get_idle_count() const
+		{
+			return this->idle.size();
+		}
+
+		/// <summary>
+		/// Get the amount of objects the pool has created, which stops growing once decoding reaches its steady state.
+		/// </summary>
+		/// <returns>Amount of objects created</returns>
+		size_t get_created_count() const
+		{
+			return this->created;
+		}
+
+	private:
+		std::vector<std::unique_ptr<T>> idle;
+		size_t max_idle;
+		size_t created = 0;
+
+		void recycle(T *object)
+		{
+			if (this->idle.size() >= this->max_idle)
+			{
+				delete object;
+				return;
+			}
+
+			// Called from the handle's deleter, which must not throw
+			try
+			{
+				this->idle.emplace_back(object);
+			}
+			catch (...)
+			{
+				delete object;
+			}
+		}
+	};
+}
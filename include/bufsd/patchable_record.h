@@ -0,0 +1,169 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "bufsd/utils.h"
+
+namespace bufsd
+{
+	class Patchable_Record;
+
+	class Record_Layout
+	{
+	public:
+		/// <summary>
+		/// Appends a fixed-width field to the layout.
+		/// <para>Fixed-width fields always occupy the same bytes of the encoded record, so they can be patched in place.</para>
+		/// </summary>
+		/// <param name="number_of_bytes">Width of the field (1 to 8 bytes)</param>
+		/// <param name="endianness">Byte order used to encode the field</param>
+		/// <exception cref="runtime_error">Occurs if <paramref name="number_of_bytes"/> is not between 1 and 8</exception>
+		/// <returns>Reference to the layout object (allows chaining methods)</returns>
+		Record_Layout &add_fixed(size_t number_of_bytes, Endianness endianness = Endianness::BIG);
+
+		/// <summary>
+		/// Appends a variable-length field to the layout, encoded as a length prefix followed by the field bytes.
+		/// <para>Changing the length of this field moves every following field, so it forces a full re-encode.</para>
+		/// </summary>
+		/// <param name="length_prefix_bytes">Width of the length prefix (1 to 8 bytes)</param>
+		/// <param name="endianness">Byte order used to encode the length prefix</param>
+		/// <exception cref="runtime_error">Occurs if <paramref name="length_prefix_bytes"/> is not between 1 and 8</exception>
+		/// <returns>Reference to the layout object (allows chaining methods)</returns>
+		Record_Layout &add_variable(size_t length_prefix_bytes = 2, Endianness endianness = Endianness::BIG);
+
+		/// <summary>
+		/// Get the amount of fields declared in the layout.
+		/// </summary>
+		/// <returns>Amount of fields</returns>
+		size_t get_field_count() const;
+
+	private:
+		friend class Patchable_Record;
+
+		struct Field
+		{
+			bool is_variable;
+			unsigned char number_of_bytes;
+			Endianness endianness;
+		};
+
+		std::vector<Field> fields;
+	};
+
+	class Patchable_Record
+	{
+	public:
+		/// <summary>
+		/// Constructs a record following <paramref name="layout"/>, with fixed fields set to 0 and variable fields empty.
+		/// </summary>
+		/// <param name="layout">Field layout of the record</param>
+		Patchable_Record(const Record_Layout &layout);
+
+		/// <summary>
+		/// Sets the value of the fixed-width field <paramref name="field"/>.
+		/// <para>The field is only marked as dirty if its encoded bytes actually change.</para>
+		/// </summary>
+		/// <typeparam name="T">Integral, enum or floating point type (stored as its bit pattern), must have the same size as the field</typeparam>
+		/// <param name="field">Index of the field in the layout</param>
+		/// <param name="value">Value to be stored</param>
+		/// <exception cref="runtime_error">Occurs if the field doesn't exist, is variable-length or has a different size than T</exception>
+		/// <returns>Reference to the record object (allows chaining methods)</returns>
+		template <typename T>
+		Patchable_Record &set(size_t field, T value)
+		{
+			static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_floating_point<T>::value, "Only integral, enum and floating point values can be stored in fixed fields");
+			static_assert(sizeof(T) <= 8, "Fixed fields are limited to 8 bytes");
+
+			this->assert_is_fixed(field, sizeof(T));
+
+			unsigned long long bits;
+
+			// A cast would round floating point values to integers, so their bit pattern is copied instead
+			if constexpr (std::is_floating_point<T>::value)
+			{
+				static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only 4 and 8 bytes floating point values can be stored in fixed fields");
+				using Bits = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+
+				Bits raw;
+				std::memcpy(&raw, &value, sizeof(T));
+				bits = raw;
+			}
+			else
+			{
+				bits = (unsigned long long)value;
+			}
+
+			unsigned char bytes[8];
+			write_integer(bytes, bits, sizeof(T), this->layout.fields[field].endianness);
+
+			return this->store(field, bytes, sizeof(T));
+		}
+
+		/// <summary>
+		/// Sets the content of the variable-length field <paramref name="field"/>.
+		/// <para>If the new content has a different length than the encoded one, the next get_buffer() call re-encodes the whole record.</para>
+		/// </summary>
+		/// <param name="field">Index of the field in the layout</param>
+		/// <param name="data">Bytes of the field</param>
+		/// <param name="size">Amount of bytes of the field</param>
+		/// <exception cref="runtime_error">Occurs if the field doesn't exist or is fixed-width</exception>
+		/// <returns>Reference to the record object (allows chaining methods)</returns>
+		Patchable_Record &set_buffer(size_t field, const unsigned char *data, size_t size);
+
+		/// <summary>
+		/// Sets the content of the variable-length field <paramref name="field"/>.
+		/// </summary>
+		/// <param name="field">Index of the field in the layout</param>
+		/// <param name="values">Bytes of the field</param>
+		/// <exception cref="runtime_error">Occurs if the field doesn't exist or is fixed-width</exception>
+		/// <returns>Reference to the record object (allows chaining methods)</returns>
+		Patchable_Record &set_buffer(size_t field, const std::vector<unsigned char> &values);
+
+		/// <summary>
+		/// Get the encoded record.
+		/// <para>Dirty fields are patched in place at their known offsets, unless a variable-length field changed its size, in which case the whole record is re-encoded.</para>
+		/// </summary>
+		/// <returns>Vector with the encoded record</returns>
+		const std::vector<unsigned char> &get_buffer();
+
+		/// <summary>
+		/// Check whether <paramref name="field"/> changed since the last get_buffer() call.
+		/// </summary>
+		/// <param name="field">Index of the field in the layout</param>
+		/// <returns>true if the field is dirty</returns>
+		bool is_dirty(size_t field) const;
+
+		/// <summary>
+		/// Check whether the next get_buffer() call will re-encode the whole record instead of patching it.
+		/// </summary>
+		/// <returns>true if a full re-encode is pending</returns>
+		bool needs_full_encode() const;
+
+		/// <summary>
+		/// Get the offset of <paramref name="field"/>'s first byte (the length prefix for variable-length fields) in the last encoded buffer.
+		/// </summary>
+		/// <param name="field">Index of the field in the layout</param>
+		/// <returns>Offset of the field</returns>
+		size_t get_field_offset(size_t field) const;
+
+	private:
+		Patchable_Record &store(size_t field, const unsigned char *data, size_t size);
+		void assert_is_fixed(size_t field, size_t size) const;
+		void encode_all();
+
+	private:
+		Record_Layout layout;
+
+		std::vector<std::vector<unsigned char>> values;
+		std::vector<size_t> offsets;
+		std::vector<size_t> dirty_fields;
+		std::vector<bool> dirty;
+
+		std::vector<unsigned char> buffer;
+		bool full_encode_pending = true;
+	};
+}
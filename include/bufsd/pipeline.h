@@ -0,0 +1,136 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <exception>
+#include <functional>
+
+#include "bufsd/bounded_queue.h"
+
+namespace bufsd
+{
+	/// <summary>
+	/// Unit of work flowing through a Pipeline. Packets are pooled, so both buffers keep their capacity from one use to the next.
+	/// </summary>
+	struct Pipeline_Packet
+	{
+		/// <summary>
+		/// Position of the packet in submission order, assigned by Pipeline::submit().
+		/// </summary>
+		unsigned long long sequence = 0;
+
+		/// <summary>
+		/// Free for the caller, e.g. the index of the batch an encoding stage has to serialize.
+		/// </summary>
+		size_t tag = 0;
+
+		/// <summary>
+		/// Current content of the packet.
+		/// </summary>
+		std::vector<unsigned char> data;
+
+		/// <summary>
+		/// Spare buffer for stages producing a new version of data (e.g. compression), which swap it with data afterwards.
+		/// </summary>
+		std::vector<unsigned char> scratch;
+
+		/// <summary>
+		/// Set when a stage threw; later stages and the sink skip the packet.
+		/// </summary>
+		bool failed = false;
+	};
+
+	using Pipeline_Function = std::function<void(Pipeline_Packet &packet)>;
+
+	class Pipeline
+	{
+	public:
+		/// <summary>
+		/// Constructs an empty pipeline.
+		/// </summary>
+		/// <param name="packet_count">Amount of pooled packets, which bounds the amount of packets in flight</param>
+		Pipeline(size_t packet_count = 64);
+		~Pipeline();
+
+		Pipeline(const Pipeline &) = delete;
+		Pipeline &operator=(const Pipeline &) = delete;
+
+		/// <summary>
+		/// Appends a stage run by <paramref name="worker_count"/> threads. Packets may leave a stage in any order.
+		/// </summary>
+		/// <param name="function">Called once per packet</param>
+		/// <param name="worker_count">Amount of threads running the stage</param>
+		/// <exception cref="runtime_error">Occurs if the pipeline is already started</exception>
+		/// <returns>Reference to the pipeline object (allows chaining methods)</returns>
+		Pipeline &add_stage(const Pipeline_Function &function, unsigned int worker_count = 1);
+
+		/// <summary>
+		/// Sets the final stage, run by a single thread that receives the packets in submission order (e.g. writing to a file).
+		/// </summary>
+		/// <param name="function">Called once per packet, in order</param>
+		/// <exception cref="runtime_error">Occurs if the pipeline is already started</exception>
+		/// <returns>Reference to the pipeline object (allows chaining methods)</returns>
+		Pipeline &set_sink(const Pipeline_Function &function);
+
+		/// <summary>
+		/// Starts the threads of every stage and of the sink.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if the pipeline is already started</exception>
+		void start();
+
+		/// <summary>
+		/// Takes a free packet from the pool, waiting until one is recycled by the sink if every packet is in flight.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if the pipeline is not started</exception>
+		/// <returns>Packet with empty buffers (capacity kept) and tag 0</returns>
+		Pipeline_Packet &acquire();
+
+		/// <summary>
+		/// Hands a packet obtained by acquire() to the first stage, giving it the next sequence number.
+		/// </summary>
+		/// <param name="packet">Packet to process</param>
+		/// <exception cref="runtime_error">Rethrows the first exception of a stage, if any</exception>
+		void submit(Pipeline_Packet &packet);
+
+		/// <summary>
+		/// Waits until every submitted packet went through the sink, then stops the threads.
+		/// </summary>
+		/// <exception cref="runtime_error">Rethrows the first exception of a stage, if any</exception>
+		void finish();
+
+	private:
+		struct Stage
+		{
+			Pipeline_Function function;
+			unsigned int worker_count;
+			std::unique_ptr<Bounded_Queue<Pipeline_Packet *>> input;
+		};
+
+		std::vector<std::unique_ptr<Pipeline_Packet>> packets;
+		Bounded_Queue<Pipeline_Packet *> free_packets;
+
+		std::vector<Stage> stages;
+		Pipeline_Function sink;
+		std::unique_ptr<Bounded_Queue<Pipeline_Packet *>> sink_input;
+
+		std::vector<std::thread> threads;
+		std::atomic<bool> stopping{false};
+		bool started = false;
+
+		unsigned long long submitted = 0;
+		std::atomic<unsigned long long> completed{0};
+
+		std::mutex error_mutex;
+		std::exception_ptr error;
+		std::atomic<bool> failed{false};
+
+		void run_stage(size_t stage);
+		void run_sink();
+		void record_error();
+		void stop();
+	};
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+// The log relies on POSIX file descriptors and mmap, so it is only declared where src/record_log.cpp is built
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+
+#include "bufsd/serializer.h"
+
+namespace bufsd
+{
+	/// <summary>
+	/// Bytes added before each record of a log: 4 bytes Big-Endian length followed by 4 bytes Big-Endian CRC-32C of the length and the record.
+	/// </summary>
+	static const size_t RECORD_LOG_FRAME_HEADER_SIZE = 8;
+
+	struct Group_Commit_Options
+	{
+		/// <summary>
+		/// Pending bytes that trigger a group commit without waiting for max_delay.
+		/// </summary>
+		size_t max_bytes = 1024 * 1024;
+
+		/// <summary>
+		/// Maximum time an appended record waits before its group is committed.
+		/// </summary>
+		std::chrono::microseconds max_delay = std::chrono::microseconds(2000);
+
+		/// <summary>
+		/// Whether each group commit calls fdatasync. Disable only when durability is handled elsewhere.
+		/// </summary>
+		bool sync = true;
+
+		/// <summary>
+		/// Pending bytes at which append blocks until the committer takes the group, so a slow disk can't make memory grow without bound.
+		/// <para>A single record larger than this is still accepted once nothing else is pending.</para>
+		/// </summary>
+		size_t max_pending_bytes = 64 * 1024 * 1024;
+	};
+
+	class Record_Log_Reader
+	{
+	public:
+		/// <summary>
+		/// Maps the log file at <paramref name="path"/> for reading (POSIX only).
+		/// </summary>
+		/// <param name="path">Path of the log file</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be opened or mapped</exception>
+		Record_Log_Reader(const std::string &path);
+
+		/// <summary>
+		/// Unmaps the log file.
+		/// </summary>
+		~Record_Log_Reader();
+
+		Record_Log_Reader(const Record_Log_Reader &) = delete;
+		Record_Log_Reader &operator=(const Record_Log_Reader &) = delete;
+
+		/// <summary>
+		/// Get the next record without copying it.
+		/// <para>Iteration stops at the end of the file or at the first frame that is truncated or fails its checksum (a torn tail).</para>
+		/// </summary>
+		/// <param name="record">Receives a pointer to the record bytes, valid while the reader exists</param>
+		/// <param name="size">Receives the size of the record</param>
+		/// <returns>false when there is no more valid record</returns>
+		bool next(const unsigned char *&record, size_t &size);
+
+		/// <summary>
+		/// Visits every remaining valid record.
+		/// </summary>
+		/// <param name="consumer">Called with each record, the pointer is valid while the reader exists</param>
+		void for_each(const std::function<void(const unsigned char *record, size_t size)> &consumer);
+
+		/// <summary>
+		/// Move the reader back to the first record.
+		/// </summary>
+		void reset();
+
+		/// <summary>
+		/// Get the offset right after the last valid record read so far.
+		/// <para>After a full iteration, this is the size the log should be truncated to.</para>
+		/// </summary>
+		/// <returns>Offset after the last valid record</returns>
+		size_t get_valid_size() const;
+
+		/// <summary>
+		/// Check whether the iteration stopped before the end of the file because of a truncated or corrupted frame.
+		/// </summary>
+		/// <returns>true if a torn tail was found</returns>
+		bool has_torn_tail() const;
+
+	private:
+		const unsigned char *data = nullptr;
+		size_t size = 0;
+		size_t cursor = 0;
+		bool torn_tail = false;
+	};
+
+	class Record_Log_Writer
+	{
+	public:
+		/// <summary>
+		/// Opens (or creates) the log file at <paramref name="path"/> for appending (POSIX only).
+		/// <para>If the file ends with a torn tail, it is truncated to the last valid record before appending.</para>
+		/// </summary>
+		/// <param name="path">Path of the log file</param>
+		/// <param name="options">Group commit configuration</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be opened or recovered</exception>
+		Record_Log_Writer(const std::string &path, const Group_Commit_Options &options = {});
+
+		/// <summary>
+		/// Commits every pending record and closes the file.
+		/// </summary>
+		~Record_Log_Writer();
+
+		Record_Log_Writer(const Record_Log_Writer &) = delete;
+		Record_Log_Writer &operator=(const Record_Log_Writer &) = delete;
+
+		/// <summary>
+		/// Appends a record to the pending group. Thread safe.
+		/// <para>The record is written and synced together with the rest of its group, once max_bytes is reached or max_delay expires. Blocks while the pending group already holds max_pending_bytes.</para>
+		/// </summary>
+		/// <param name="record">Pointer to the first byte of the record</param>
+		/// <param name="size">Size of the record</param>
+		/// <exception cref="runtime_error">Occurs if a previous group commit failed</exception>
+		/// <returns>Sequence number of the record, starting at 1 for each writer</returns>
+		unsigned long long append(const unsigned char *record, size_t size);
+
+		/// <summary>
+		/// Appends a record to the pending group. Thread safe.
+		/// </summary>
+		/// <param name="record">Bytes of the record</param>
+		/// <exception cref="runtime_error">Occurs if a previous group commit failed</exception>
+		/// <returns>Sequence number of the record</returns>
+		unsigned long long append(const std::vector<unsigned char> &record);
+
+		/// <summary>
+		/// Appends the buffer of <paramref name="serializer"/> as a record. Thread safe.
+		/// </summary>
+		/// <param name="serializer">Serializer holding the record</param>
+		/// <exception cref="runtime_error">Occurs if a previous group commit failed</exception>
+		/// <returns>Sequence number of the record</returns>
+		unsigned long long append(Serializer &serializer);
+
+		/// <summary>
+		/// Blocks until the record with <paramref name="sequence"/> (and every record before it) is durable.
+		/// </summary>
+		/// <param name="sequence">Sequence number returned by append</param>
+		/// <exception cref="runtime_error">Occurs if the group commit failed</exception>
+		void wait_durable(unsigned long long sequence);
+
+		/// <summary>
+		/// Commits every pending record right away and waits for it to be durable.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if the group commit failed</exception>
+		void commit();
+
+		/// <summary>
+		/// Get the sequence number of the last durable record.
+		/// </summary>
+		/// <returns>Last durable sequence number (0 if none)</returns>
+		unsigned long long get_durable_sequence();
+
+	private:
+		void run_committer();
+		void assert_no_error() const;
+
+	private:
+		Group_Commit_Options options;
+		std::string path;
+		int fd = -1;
+
+		std::mutex mutex;
+		std::condition_variable wake_committer;
+		std::condition_variable wake_waiters;
+		std::condition_variable wake_appenders;
+		std::thread committer;
+
+		std::vector<unsigned char> pending;
+		std::chrono::steady_clock::time_point first_pending_time;
+		unsigned long long appended_sequence = 0;
+		unsigned long long durable_sequence = 0;
+		bool flush_requested = false;
+		bool stopping = false;
+		std::string error;
+	};
+}
+
+#endif
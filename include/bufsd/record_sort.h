@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "bufsd/framing.h"
+
+namespace bufsd
+{
+	struct Record_Sort_Options
+	{
+		/// <summary>
+		/// Format of the length prefix before each record.
+		/// </summary>
+		Length_Prefix prefix;
+
+		/// <summary>
+		/// Position of the first key byte, counted from the start of the record (after its length prefix).
+		/// </summary>
+		size_t key_offset = 0;
+
+		/// <summary>
+		/// Maximum amount of key bytes. Records ending before that use the bytes they have, which sort before longer keys with the same prefix.
+		/// </summary>
+		size_t key_length = SIZE_MAX;
+	};
+
+	/// <summary>
+	/// Sorts a buffer of length-prefixed records by the key bytes of each record, comparing them as memcmp would.
+	/// <para>Uses an MSD radix sort over the key bytes without decoding the records. Records with equal keys keep their original order.</para>
+	/// </summary>
+	/// <param name="records">Concatenated length-prefixed records</param>
+	/// <param name="options">Prefix format and key position</param>
+	/// <exception cref="runtime_error">Occurs if the last record is truncated or the prefix width is not between 1 and 8</exception>
+	/// <returns>Vector with the same records, sorted</returns>
+	std::vector<unsigned char> sort_records(const std::vector<unsigned char> &records, const Record_Sort_Options &options = {});
+
+	struct External_Sort_Options
+	{
+		/// <summary>
+		/// Amount of record bytes kept in memory before a sorted run is spilled to disk.
+		/// </summary>
+		size_t memory_limit = 64 * 1024 * 1024;
+
+		/// <summary>
+		/// Size of the read buffer of each run during the merge.
+		/// </summary>
+		size_t merge_buffer_size = 256 * 1024;
+
+		/// <summary>
+		/// Directory where the sorted runs are written. Empty uses the system temporary directory.
+		/// </summary>
+		std::string temporary_directory;
+	};
+
+	class External_Record_Sorter
+	{
+	public:
+		/// <summary>
+		/// Constructs a sorter that keeps at most about <paramref name="external_options"/>.memory_limit bytes of records in memory.
+		/// </summary>
+		/// <param name="options">Prefix format and key position</param>
+		/// <param name="external_options">Memory and spilling configuration</param>
+		/// <exception cref="runtime_error">Occurs if the prefix width is not between 1 and 8</exception>
+		External_Record_Sorter(const Record_Sort_Options &options = {}, const External_Sort_Options &external_options = {});
+
+		/// <summary>
+		/// Removes any run file still on disk.
+		/// </summary>
+		~External_Record_Sorter();
+
+		External_Record_Sorter(const External_Record_Sorter &) = delete;
+		External_Record_Sorter &operator=(const External_Record_Sorter &) = delete;
+
+		/// <summary>
+		/// Adds one record (without its length prefix) to be sorted.
+		/// <para>When the in-memory records reach the memory limit, they are sorted and spilled to a run file.</para>
+		/// </summary>
+		/// <param name="record">Pointer to the first byte of the record</param>
+		/// <param name="size">Size of the record</param>
+		/// <exception cref="runtime_error">Occurs if a run file can't be written</exception>
+		void add(const unsigned char *record, size_t size);
+
+		/// <summary>
+		/// Adds one record (without its length prefix) to be sorted.
+		/// </summary>
+		/// <param name="record">Bytes of the record</param>
+		/// <exception cref="runtime_error">Occurs if a run file can't be written</exception>
+		void add(const std::vector<unsigned char> &record);
+
+		/// <summary>
+		/// Merges every run and hands the records, in key order, to <paramref name="consumer"/>.
+		/// <para>The runs are read in a streaming k-way merge, so memory stays bounded by the read buffers. The sorter is empty afterwards.</para>
+		/// </summary>
+		/// <param name="consumer">Called with each record (without its length prefix), the pointer is only valid during the call</param>
+		/// <exception cref="runtime_error">Occurs if a run file can't be read</exception>
+		void finish(const std::function<void(const unsigned char *record, size_t size)> &consumer);
+
+		/// <summary>
+		/// Merges every run and writes the sorted length-prefixed records to <paramref name="path"/>.
+		/// </summary>
+		/// <param name="path">Output file path</param>
+		/// <exception cref="runtime_error">Occurs if a run or the output file can't be accessed</exception>
+		void finish(const std::string &path);
+
+		/// <summary>
+		/// Get the amount of runs spilled to disk so far.
+		/// </summary>
+		/// <returns>Amount of runs</returns>
+		size_t get_run_count() const;
+
+	private:
+		void spill();
+		void remove_runs();
+
+	private:
+		Record_Sort_Options options;
+		External_Sort_Options external_options;
+
+		std::vector<unsigned char> records;
+		std::vector<std::string> runs;
+	};
+}
@@ -4,9 +4,14 @@
 #include <string>
 #include <sstream>
 #include <cassert>
+#include <cstring>
 #include <iomanip>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
 
 #include "bufsd/serializable.h"
+#include "bufsd/key_encoding.h"
 #include "bufsd/utils.h"
 
 namespace bufsd
@@ -187,6 +192,87 @@ namespace bufsd
 			return *this;
 		}
 
+		/// <summary>
+		/// Pushes <paramref name="size"/> bytes starting at <paramref name="data"/> to the buffer, keeping the bytes order.
+		/// </summary>
+		/// <param name="data">Pointer to the first byte to be pushed</param>
+		/// <param name="size">Amount of bytes to be pushed</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		Serializer &push_buffer(const unsigned char *data, size_t size)
+		{
+			this->buffer.insert(this->buffer.end(), data, data + size);
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Pushes <paramref name="count"/> numbers back to back with <paramref name="endianness"/> order.
+		/// <para>Copies them all at once and only swaps bytes when <paramref name="endianness"/> is not the host's, instead of encoding one number at a time.</para>
+		/// </summary>
+		/// <typeparam name="T">Arithmetic type of the numbers, whose size is the size of each pushed number</typeparam>
+		/// <param name="values">Pointer to the first number</param>
+		/// <param name="count">Amount of numbers to push</param>
+		/// <param name="endianness">Byte order of the pushed numbers</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		Serializer &push_array(const T *values, size_t count, Endianness endianness)
+		{
+			static_assert(std::is_arithmetic<T>::value, "push_array only pushes numbers");
+
+			const size_t size = count * sizeof(T);
+			const size_t position = this->buffer.size();
+
+			if (size == 0)
+				return *this;
+
+			this->buffer.resize(position + size);
+			unsigned char *bytes = this->buffer.data() + position;
+			std::memcpy(bytes, values, size);
+
+			if (sizeof(T) > 1 && endianness != get_host_endianness())
+			{
+				for (size_t i = 0; i < count; i++)
+					std::reverse(bytes + i * sizeof(T), bytes + (i + 1) * sizeof(T));
+			}
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Moves the bytes and deferred spots of <paramref name="fragment"/> to the end of the buffer, so fragments built separately (for example in parallel) can be joined.
+		/// <para>Unlike push_buffer, the deferred spots of the fragment are kept, moved by the position where the fragment lands, so they receive the size of the joined buffer. If this buffer is empty, the fragment's buffer is taken without copying.</para>
+		/// <para>The fragment is left empty, keeping an allocated buffer for reuse.</para>
+		/// </summary>
+		/// <param name="fragment">Buffer maker to join (must not be this one)</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		Serializer &append(Serializer &&fragment)
+		{
+			if (&fragment == this)
+				return *this;
+
+			if (this->buffer.empty() && this->deferred_sizes.empty())
+			{
+				std::swap(this->buffer, fragment.buffer);
+				std::swap(this->deferred_sizes, fragment.deferred_sizes);
+			}
+			else
+			{
+				const size_t offset = this->buffer.size();
+
+				this->buffer.insert(this->buffer.end(), fragment.buffer.begin(), fragment.buffer.end());
+
+				for (Deferred_Buffer_Size deferred : fragment.deferred_sizes)
+				{
+					deferred.index += offset;
+					this->deferred_sizes.push_back(deferred);
+				}
+			}
+
+			fragment.clear();
+
+			return *this;
+		}
+
 		/// <summary>
 		/// Pushes any object that implements Serializable interface.
 		/// <para>It calls the serialize() method and push the buffer.
@@ -214,6 +300,75 @@ namespace bufsd
 			return this->push_little_endian(value);
 		}
 
+		/// <summary>
+		/// Pushes <paramref name="value"/> as an order-preserving key field, so that comparing encoded keys with memcmp gives the same order as comparing the values.
+		/// <para>Unsigned, signed and floating point values are supported, always using sizeof(T) bytes. Fields pushed one after another form a composite key compared field by field.</para>
+		/// <example>The int -1 is pushed as { 0x7f, 0xff, 0xff, 0xff } and the int 1 as { 0x80, 0x00, 0x00, 0x01 }.</example>
+		/// </summary>
+		/// <typeparam name="T">The type of the number, used to know how many bytes will be pushed</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <param name="order">Sort direction of this field (DESCENDING inverts every byte)</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+		Serializer &push_key(T value, Key_Order order = Key_Order::ASCENDING)
+		{
+			unsigned long long key = to_key_bits(value);
+
+			if (order == Key_Order::DESCENDING)
+				key = ~key;
+
+			for (int i = sizeof(T) - 1; i >= 0; i--)
+				this->buffer.push_back((key >> (i * 8)) & 0xff);
+			return *this;
+		}
+
+		/// <summary>
+		/// Pushes <paramref name="size"/> bytes starting at <paramref name="data"/> as an order-preserving key field.
+		/// <para>Every 0x00 byte is escaped as { 0x00, 0xff } and the field is terminated by { 0x00, 0x01 }, so shorter values sort before longer values with the same prefix and the fields that follow are never mixed with this one.</para>
+		/// </summary>
+		/// <param name="data">Pointer to the first byte of the field</param>
+		/// <param name="size">Amount of bytes of the field</param>
+		/// <param name="order">Sort direction of this field (DESCENDING inverts every byte)</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		Serializer &push_key(const unsigned char *data, size_t size, Key_Order order = Key_Order::ASCENDING)
+		{
+			const unsigned char flip = order == Key_Order::DESCENDING ? 0xff : 0x00;
+
+			for (size_t i = 0; i < size; i++)
+			{
+				this->buffer.push_back(data[i] ^ flip);
+
+				if (data[i] == 0x00)
+					this->buffer.push_back(0xff ^ flip);
+			}
+
+			this->buffer.push_back(0x00 ^ flip);
+			this->buffer.push_back(0x01 ^ flip);
+			return *this;
+		}
+
+		/// <summary>
+		/// Pushes <paramref name="value"/> as an order-preserving key field (see the pointer overload for the format).
+		/// </summary>
+		/// <param name="value">String to be pushed</param>
+		/// <param name="order">Sort direction of this field</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		Serializer &push_key(const std::string &value, Key_Order order = Key_Order::ASCENDING)
+		{
+			return this->push_key(reinterpret_cast<const unsigned char *>(value.data()), value.size(), order);
+		}
+
+		/// <summary>
+		/// Pushes <paramref name="values"/> as an order-preserving key field (see the pointer overload for the format).
+		/// </summary>
+		/// <param name="values">Bytes to be pushed</param>
+		/// <param name="order">Sort direction of this field</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		Serializer &push_key(const std::vector<unsigned char> &values, Key_Order order = Key_Order::ASCENDING)
+		{
+			return this->push_key(values.data(), values.size(), order);
+		}
+
 		/// <summary>
 		/// Get the buffer that is being constructed.
 		/// <para>Before returning the buffer, the buffer's size will be placed in each deferred spot.</para>
@@ -235,6 +390,101 @@ namespace bufsd
 			return this->buffer.size();
 		}
 
+		/// <summary>
+		/// Removes every byte and deferred spot from the buffer, keeping the allocated capacity for reuse.
+		/// </summary>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		Serializer &clear()
+		{
+			this->buffer.clear();
+			this->deferred_sizes.clear();
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Position of the buffer saved by checkpoint() to undo what was pushed after it.
+		/// </summary>
+		struct Checkpoint
+		{
+			size_t buffer_size;
+			size_t deferred_count;
+		};
+
+		/// <summary>
+		/// Saves the current end of the buffer, so bytes and deferred spots pushed after it can be dropped with rollback().
+		/// <para>Useful for speculative appends, such as adding records to a packet until one exceeds the MTU.</para>
+		/// </summary>
+		/// <returns>Checkpoint of the current buffer end</returns>
+		Checkpoint checkpoint() const
+		{
+			return {this->buffer.size(), this->deferred_sizes.size()};
+		}
+
+		/// <summary>
+		/// Removes every byte and deferred spot pushed after <paramref name="checkpoint"/>, keeping the allocated capacity, in constant time.
+		/// <para>Bytes before the checkpoint that were patched afterwards keep their new value.</para>
+		/// </summary>
+		/// <param name="checkpoint">Checkpoint taken on this buffer</param>
+		/// <exception cref="runtime_error">Occurs if the buffer is already shorter than the checkpoint (cleared or rolled back further)</exception>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		Serializer &rollback(const Checkpoint &checkpoint)
+		{
+			if (checkpoint.buffer_size > this->buffer.size() || checkpoint.deferred_count > this->deferred_sizes.size())
+				throw std::runtime_error("Tried to roll back to " + std::to_string(checkpoint.buffer_size) + " byte(s), but the buffer has only " + std::to_string(this->buffer.size()) + " byte(s)");
+
+			this->buffer.resize(checkpoint.buffer_size);
+			this->deferred_sizes.resize(checkpoint.deferred_count);
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Pushes <paramref name="amount_of_bytes"/> zero bytes to be filled later with patch_big_endian or patch_little_endian.
+		/// <para>Useful for fields only known after the following bytes were pushed, such as offset tables.</para>
+		/// </summary>
+		/// <param name="amount_of_bytes">Amount of placeholder bytes</param>
+		/// <returns>Position of the first placeholder byte</returns>
+		size_t push_placeholder(size_t amount_of_bytes)
+		{
+			size_t position = this->buffer.size();
+			this->buffer.resize(position + amount_of_bytes, 0);
+
+			return position;
+		}
+
+		/// <summary>
+		/// Overwrites sizeof(T) bytes at <paramref name="position"/> with <paramref name="value"/> in Big-Endian (not inverting the order).
+		/// </summary>
+		/// <typeparam name="T">The type of the number, used to know how many bytes will be written</typeparam>
+		/// <param name="position">Position of the first byte to overwrite</param>
+		/// <param name="value">Value to be written</param>
+		/// <exception cref="runtime_error">Occurs if the bytes to overwrite go beyond the end of the buffer</exception>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		Serializer &patch_big_endian(size_t position, T value)
+		{
+			this->assert_can_patch(position, sizeof(T));
+			write_integer(this->buffer.data() + position, (unsigned long long)value, sizeof(T), Endianness::BIG);
+			return *this;
+		}
+
+		/// <summary>
+		/// Overwrites sizeof(T) bytes at <paramref name="position"/> with <paramref name="value"/> in Little-Endian (inverting the order).
+		/// </summary>
+		/// <typeparam name="T">The type of the number, used to know how many bytes will be written</typeparam>
+		/// <param name="position">Position of the first byte to overwrite</param>
+		/// <param name="value">Value to be written</param>
+		/// <exception cref="runtime_error">Occurs if the bytes to overwrite go beyond the end of the buffer</exception>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		Serializer &patch_little_endian(size_t position, T value)
+		{
+			this->assert_can_patch(position, sizeof(T));
+			write_integer(this->buffer.data() + position, (unsigned long long)value, sizeof(T), Endianness::LITTLE);
+			return *this;
+		}
+
 		/// <summary>
 		/// Print the internal buffer specifying the size and separating each byte using <paramref name="sep"/> character.
 		/// <para>Before printing the buffer, the buffer's size will be placed in each deferred spot.</para>
@@ -280,6 +530,12 @@ namespace bufsd
 		}
 
 	private:
+		void assert_can_patch(size_t position, size_t amount_of_bytes) const
+		{
+			if (position > this->buffer.size() || this->buffer.size() - position < amount_of_bytes)
+				throw std::runtime_error("Tried to patch " + std::to_string(amount_of_bytes) + " byte(s) at position " + std::to_string(position) + ", but the buffer has only " + std::to_string(this->buffer.size()) + " byte(s)");
+		}
+
 		void insert_buffer_sizes()
 		{
 			size_t buffer_size = this->buffer.size();
@@ -294,12 +550,6 @@ namespace bufsd
 		}
 
 	private:
-		enum class Endianness
-		{
-			BIG,
-			LITTLE
-		};
-
 		struct Deferred_Buffer_Size
 		{
 			size_t index;
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	struct Shm_Channel_Header;
+
+	/// <summary>
+	/// Removes the shared-memory object of the channel <paramref name="name"/> (Linux only). Processes already attached keep their mapping.
+	/// </summary>
+	/// <param name="name">Name of the channel, as given to shm_open (e.g. "/bufsd-frames")</param>
+	void unlink_shm_channel(const std::string &name);
+
+	class Shm_Channel_Writer
+	{
+	public:
+		/// <summary>
+		/// Creates the shared-memory channel <paramref name="name"/>, or attaches to it if it already exists (Linux only).
+		/// <para>A restarted producer continues after the last committed frame and sequence number; a frame it was writing when it crashed is never visible to the consumer.</para>
+		/// </summary>
+		/// <param name="name">Name of the channel, as given to shm_open (e.g. "/bufsd-frames")</param>
+		/// <param name="capacity">Size of the ring in bytes, rounded up to a power of two (ignored when attaching)</param>
+		/// <exception cref="runtime_error">Occurs if the shared memory can't be created or mapped, or holds something else</exception>
+		Shm_Channel_Writer(const std::string &name, size_t capacity = 1024 * 1024);
+		~Shm_Channel_Writer();
+
+		Shm_Channel_Writer(const Shm_Channel_Writer &) = delete;
+		Shm_Channel_Writer &operator=(const Shm_Channel_Writer &) = delete;
+
+		/// <summary>
+		/// Reserves room for a frame of up to <paramref name="size"/> bytes directly in the ring, waiting for the consumer if it is full.
+		/// </summary>
+		/// <param name="size">Maximum size of the frame</param>
+		/// <exception cref="runtime_error">Occurs if the frame can never fit in the ring</exception>
+		/// <returns>Pointer where the frame can be written, valid until commit()</returns>
+		unsigned char *reserve(size_t size);
+
+		/// <summary>
+		/// Publishes the reserved frame and wakes the consumer if it is waiting.
+		/// </summary>
+		/// <param name="size">Actual size of the frame, at most the reserved size</param>
+		/// <exception cref="runtime_error">Occurs if nothing is reserved or <paramref name="size"/> exceeds the reservation</exception>
+		/// <returns>Sequence number of the frame</returns>
+		unsigned long long commit(size_t size);
+
+		/// <summary>
+		/// Copies a frame into the ring and publishes it.
+		/// </summary>
+		/// <param name="data">Pointer to the first byte of the frame</param>
+		/// <param name="size">Size of the frame</param>
+		/// <exception cref="runtime_error">Occurs if the frame can never fit in the ring</exception>
+		/// <returns>Sequence number of the frame</returns>
+		unsigned long long write(const unsigned char *data, size_t size);
+
+		/// <summary>
+		/// Copies the buffer of <paramref name="serializer"/> into the ring and publishes it.
+		/// </summary>
+		/// <param name="serializer">Serializer holding the frame</param>
+		/// <exception cref="runtime_error">Occurs if the frame can never fit in the ring</exception>
+		/// <returns>Sequence number of the frame</returns>
+		unsigned long long write(Serializer &serializer);
+
+		/// <summary>
+		/// Get the size of the ring.
+		/// </summary>
+		/// <returns>Capacity in bytes</returns>
+		size_t get_capacity() const;
+
+	private:
+		int fd = -1;
+		void *mapping = nullptr;
+		size_t mapping_size = 0;
+		Shm_Channel_Header *header = nullptr;
+		unsigned char *ring = nullptr;
+
+		unsigned long long sequence = 0;
+
+		bool reserved = false;
+		unsigned long long reserved_position = 0;
+		size_t reserved_size = 0;
+	};
+
+	class Shm_Channel_Reader
+	{
+	public:
+		/// <summary>
+		/// Attaches to the existing shared-memory channel <paramref name="name"/> (Linux only).
+		/// <para>A restarted consumer resumes after the last frame it released.</para>
+		/// </summary>
+		/// <param name="name">Name of the channel, as given to shm_open (e.g. "/bufsd-frames")</param>
+		/// <exception cref="runtime_error">Occurs if the channel doesn't exist or holds something else</exception>
+		Shm_Channel_Reader(const std::string &name);
+		~Shm_Channel_Reader();
+
+		Shm_Channel_Reader(const Shm_Channel_Reader &) = delete;
+		Shm_Channel_Reader &operator=(const Shm_Channel_Reader &) = delete;
+
+		/// <summary>
+		/// Get the next frame without waiting, releasing the previous one.
+		/// </summary>
+		/// <param name="frame">Receives a non-owning view over the frame in shared memory, valid until the next call or release()</param>
+		/// <exception cref="runtime_error">Occurs if a sequence number is missing (the ring is corrupted)</exception>
+		/// <returns>false if no frame is available</returns>
+		bool try_next(Deserializer &frame);
+
+		/// <summary>
+		/// Get the next frame, sleeping on a futex until the producer publishes one.
+		/// </summary>
+		/// <param name="frame">Receives a non-owning view over the frame in shared memory, valid until the next call or release()</param>
+		/// <param name="timeout_ms">Maximum waiting time in milliseconds, or -1 to wait forever</param>
+		/// <exception cref="runtime_error">Occurs if a sequence number is missing (the ring is corrupted)</exception>
+		/// <returns>false on timeout</returns>
+		bool next(Deserializer &frame, int timeout_ms = -1);
+
+		/// <summary>
+		/// Gives the space of the current frame back to the producer.
+		/// </summary>
+		void release();
+
+		/// <summary>
+		/// Get the sequence number of the current frame.
+		/// </summary>
+		/// <returns>Sequence number, starting from 1</returns>
+		unsigned long long get_sequence() const;
+
+	private:
+		int fd = -1;
+		void *mapping = nullptr;
+		size_t mapping_size = 0;
+		Shm_Channel_Header *header = nullptr;
+		unsigned char *ring = nullptr;
+
+		unsigned long long pending_release = 0;
+		unsigned long long sequence = 0;
+	};
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+namespace bufsd
+{
+	/// <summary>
+	/// Buffer maker usable in constant expressions, encoding into a std::array of exactly <typeparamref name="N"/> bytes.
+	/// <para>Handshakes, magic headers and canned responses built with it are computed by the compiler and stored in read-only data, so sending them needs no encoding at all. Errors that would throw at runtime fail the compilation instead.</para>
+	/// </summary>
+	/// <typeparam name="N">Size of the message</typeparam>
+	template <size_t N>
+	class Static_Serializer
+	{
+	public:
+		/// <summary>
+		/// Constructs a new empty buffer maker, with all bytes set to 0.
+		/// </summary>
+		constexpr Static_Serializer()
+			: buffer{}
+		{
+		}
+
+		/// <summary>
+		/// Pushes <paramref name="value"/>'s bytes to the buffer in Big-Endian (not inverting the order).
+		/// </summary>
+		/// <typeparam name="T">Integral type of the number, used to know how many bytes will be pushed</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <exception cref="runtime_error">Occurs if the buffer has no room for sizeof(T) more bytes</exception>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_big_endian(T value)
+		{
+			static_assert(std::is_integral<T>::value, "Static_Serializer only pushes integers");
+
+			this->assert_has_room(sizeof(T));
+
+			for (size_t i = 0; i < sizeof(T); i++)
+				this->buffer[this->size++] = (unsigned char)(((unsigned long long)value >> ((sizeof(T) - 1 - i) * 8)) & 0xff);
+			return *this;
+		}
+
+		/// <summary>
+		/// Pushes <paramref name="value"/>'s bytes to the buffer in Little-Endian (inverting the order).
+		/// </summary>
+		/// <typeparam name="T">Integral type of the number, used to know how many bytes will be pushed</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <exception cref="runtime_error">Occurs if the buffer has no room for sizeof(T) more bytes</exception>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_little_endian(T value)
+		{
+			static_assert(std::is_integral<T>::value, "Static_Serializer only pushes integers");
+
+			this->assert_has_room(sizeof(T));
+
+			for (size_t i = 0; i < sizeof(T); i++)
+				this->buffer[this->size++] = (unsigned char)(((unsigned long long)value >> (i * 8)) & 0xff);
+			return *this;
+		}
+
+		/// <summary>
+		/// Pushes a 1 byte value to the buffer.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, which must have 1 byte</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_byte(T value)
+		{
+			static_assert(sizeof(T) == 1, "push_byte only accepts 1 byte values");
+			return this->push_big_endian(value);
+		}
+
+		/// <summary>
+		/// Pushes a 2 bytes value to the buffer in Big-Endian.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, which must have 2 bytes</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_16_big_endian(T value)
+		{
+			static_assert(sizeof(T) == 2, "push_16_big_endian only accepts 2 bytes values");
+			return this->push_big_endian(value);
+		}
+
+		/// <summary>
+		/// Pushes a 4 bytes value to the buffer in Big-Endian.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, which must have 4 bytes</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_32_big_endian(T value)
+		{
+			static_assert(sizeof(T) == 4, "push_32_big_endian only accepts 4 bytes values");
+			return this->push_big_endian(value);
+		}
+
+		/// <summary>
+		/// Pushes an 8 bytes value to the buffer in Big-Endian.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, which must have 8 bytes</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_64_big_endian(T value)
+		{
+			static_assert(sizeof(T) == 8, "push_64_big_endian only accepts 8 bytes values");
+			return this->push_big_endian(value);
+		}
+
+		/// <summary>
+		/// Pushes a 2 bytes value to the buffer in Little-Endian.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, which must have 2 bytes</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_16_little_endian(T value)
+		{
+			static_assert(sizeof(T) == 2, "push_16_little_endian only accepts 2 bytes values");
+			return this->push_little_endian(value);
+		}
+
+		/// <summary>
+		/// Pushes a 4 bytes value to the buffer in Little-Endian.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, which must have 4 bytes</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_32_little_endian(T value)
+		{
+			static_assert(sizeof(T) == 4, "push_32_little_endian only accepts 4 bytes values");
+			return this->push_little_endian(value);
+		}
+
+		/// <summary>
+		/// Pushes an 8 bytes value to the buffer in Little-Endian.
+		/// </summary>
+		/// <typeparam name="T">The type of the number, which must have 8 bytes</typeparam>
+		/// <param name="value">Value to be pushed</param>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <typename T>
+		constexpr Static_Serializer &push_64_little_endian(T value)
+		{
+			static_assert(sizeof(T) == 8, "push_64_little_endian only accepts 8 bytes values");
+			return this->push_little_endian(value);
+		}
+
+		/// <summary>
+		/// Pushes <paramref name="size"/> bytes starting at <paramref name="data"/> to the buffer, keeping the bytes order.
+		/// </summary>
+		/// <param name="data">Pointer to the first byte to be pushed</param>
+		/// <param name="size">Amount of bytes to be pushed</param>
+		/// <exception cref="runtime_error">Occurs if the buffer has no room for the bytes</exception>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		constexpr Static_Serializer &push_buffer(const unsigned char *data, size_t size)
+		{
+			this->assert_has_room(size);
+
+			for (size_t i = 0; i < size; i++)
+				this->buffer[this->size++] = data[i];
+			return *this;
+		}
+
+		/// <summary>
+		/// Pushes the bytes of <paramref name="values"/>, for example a message built by another Static_Serializer.
+		/// </summary>
+		/// <param name="values">Bytes to be pushed</param>
+		/// <exception cref="runtime_error">Occurs if the buffer has no room for the bytes</exception>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <size_t M>
+		constexpr Static_Serializer &push_buffer(const std::array<unsigned char, M> &values)
+		{
+			this->assert_has_room(M);
+
+			for (size_t i = 0; i < M; i++)
+				this->buffer[this->size++] = values[i];
+			return *this;
+		}
+
+		/// <summary>
+		/// Pushes the characters of the string literal <paramref name="text"/>, without its terminating null character.
+		/// </summary>
+		/// <param name="text">String literal to be pushed</param>
+		/// <exception cref="runtime_error">Occurs if the buffer has no room for the characters</exception>
+		/// <returns>Reference to the buffer maker object (allows chaining methods)</returns>
+		template <size_t M>
+		constexpr Static_Serializer &push_string(const char (&text)[M])
+		{
+			this->assert_has_room(M - 1);
+
+			for (size_t i = 0; i + 1 < M; i++)
+				this->buffer[this->size++] = (unsigned char)text[i];
+			return *this;
+		}
+
+		/// <summary>
+		/// Get the encoded message.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if fewer than N bytes were pushed, so a wrong message size fails the compilation</exception>
+		/// <returns>Array with the encoded message</returns>
+		constexpr const std::array<unsigned char, N> &get_buffer() const
+		{
+			if (this->size != N)
+				throw std::runtime_error("Static buffer of " + std::to_string(N) + " bytes holds only " + std::to_string(this->size) + " byte(s)");
+
+			return this->buffer;
+		}
+
+		/// <summary>
+		/// Get the amount of bytes pushed so far.
+		/// </summary>
+		/// <returns>Current buffer size</returns>
+		constexpr size_t get_buffer_size() const
+		{
+			return this->size;
+		}
+
+	private:
+		constexpr void assert_has_room(size_t amount_of_bytes) const
+		{
+			if (N - this->size < amount_of_bytes)
+				throw std::runtime_error("Tried to push " + std::to_string(amount_of_bytes) + " byte(s), but the static buffer has only " + std::to_string(N - this->size) + " byte(s) left");
+		}
+
+	private:
+		std::array<unsigned char, N> buffer;
+		size_t size = 0;
+	};
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstddef>
+#include <functional>
+
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	struct Table_Options
+	{
+		/// <summary>
+		/// Target size of each data block. A block is closed as soon as it reaches this size.
+		/// </summary>
+		size_t block_size = 4096;
+
+		/// <summary>
+		/// Bits of the bloom filter per key (about 1% false positives with 10 bits).
+		/// </summary>
+		size_t bloom_bits_per_key = 10;
+	};
+
+	class Table_Builder
+	{
+	public:
+		/// <summary>
+		/// Creates (or truncates) the table file at <paramref name="path"/>.
+		/// </summary>
+		/// <param name="path">Path of the table file</param>
+		/// <param name="options">Block and bloom filter configuration</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be created</exception>
+		Table_Builder(const std::string &path, const Table_Options &options = {});
+
+		/// <summary>
+		/// Appends a record to the table.
+		/// <para>Keys must be added in strictly increasing memcmp order (see Serializer::push_key). Each key is stored as the suffix that differs from the previous key of the same block.</para>
+		/// </summary>
+		/// <param name="key">Key bytes (up to 65535 bytes)</param>
+		/// <param name="value">Value bytes (up to 4294967295 bytes)</param>
+		/// <exception cref="runtime_error">Occurs if the key is not greater than the previous one, the key or the value is too big, or the table was already finished</exception>
+		void add(const std::vector<unsigned char> &key, const std::vector<unsigned char> &value);
+
+		/// <summary>
+		/// Writes the last data block, the sparse index, the bloom filter and the footer, then closes the file.
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if the file can't be written</exception>
+		void finish();
+
+		/// <summary>
+		/// Get the amount of records added so far.
+		/// </summary>
+		/// <returns>Amount of records</returns>
+		size_t get_entry_count() const;
+
+	private:
+		void flush_block();
+
+	private:
+		Table_Options options;
+		std::string path;
+		std::ofstream file;
+		bool finished = false;
+
+		Serializer block;
+		Serializer index;
+		std::vector<unsigned char> block_first_key;
+		std::vector<unsigned char> last_key;
+		std::vector<unsigned long long> key_hashes;
+
+		unsigned long long offset = 0;
+		size_t entry_count = 0;
+	};
+
+	class Table_Reader
+	{
+	public:
+		/// <summary>
+		/// Opens and maps the table file at <paramref name="path"/>, loading its sparse index.
+		/// </summary>
+		/// <param name="path">Path of the table file</param>
+		/// <exception cref="runtime_error">Occurs if the file can't be opened or is not a valid table</exception>
+		Table_Reader(const std::string &path);
+
+		/// <summary>
+		/// Unmaps the table file.
+		/// </summary>
+		~Table_Reader();
+
+		Table_Reader(const Table_Reader &) = delete;
+		Table_Reader &operator=(const Table_Reader &) = delete;
+
+		/// <summary>
+		/// Looks up <paramref name="key"/>: checks the bloom filter, binary searches the sparse index and decodes a single data block.
+		/// </summary>
+		/// <param name="key">Key bytes</param>
+		/// <param name="value">Receives the value when the key is found</param>
+		/// <exception cref="runtime_error">Occurs if the data block is corrupted</exception>
+		/// <returns>true if the key was found</returns>
+		bool get(const std::vector<unsigned char> &key, std::vector<unsigned char> &value) const;
+
+		/// <summary>
+		/// Check whether the bloom filter allows <paramref name="key"/> to be in the table.
+		/// </summary>
+		/// <param name="key">Key bytes</param>
+		/// <returns>false if the key is certainly not in the table</returns>
+		bool may_contain(const std::vector<unsigned char> &key) const;
+
+		/// <summary>
+		/// Visits every record of the table in key order.
+		/// </summary>
+		/// <param name="consumer">Called with each key and value</param>
+		/// <exception cref="runtime_error">Occurs if a data block is corrupted</exception>
+		void for_each(const std::function<void(const std::vector<unsigned char> &key, const std::vector<unsigned char> &value)> &consumer) const;
+
+		/// <summary>
+		/// Get the amount of records in the table.
+		/// </summary>
+		/// <returns>Amount of records</returns>
+		size_t get_entry_count() const;
+
+	private:
+		struct Index_Entry
+		{
+			const unsigned char *first_key;
+			size_t first_key_size;
+			size_t offset;
+			size_t size;
+		};
+
+		bool scan_block(const Index_Entry &entry, const std::function<bool(const std::vector<unsigned char> &key, Deserializer &deserializer, size_t value_size)> &visitor) const;
+
+	private:
+		const unsigned char *data = nullptr;
+		size_t size = 0;
+		std::vector<unsigned char> fallback;
+
+		std::vector<Index_Entry> blocks;
+		const unsigned char *bloom = nullptr;
+		size_t bloom_bits = 0;
+		unsigned char bloom_probes = 0;
+		size_t entry_count = 0;
+	};
+}
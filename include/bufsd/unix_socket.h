@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <functional>
+
+#include "bufsd/framing.h"
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	/// <summary>
+	/// Creates a connected pair of Unix-domain stream sockets (POSIX only), handy for local IPC between threads or forked processes.
+	/// </summary>
+	/// <exception cref="runtime_error">Occurs if the sockets can't be created</exception>
+	/// <returns>Both file descriptors, owned by the caller</returns>
+	std::pair<int, int> make_unix_socket_pair();
+
+	class Unix_Frame_Sender
+	{
+	public:
+		/// <summary>
+		/// Constructs a sender writing length-prefixed frames to the stream socket <paramref name="fd"/> (POSIX only).
+		/// </summary>
+		/// <param name="fd">Connected stream socket, not owned by the sender</param>
+		/// <param name="prefix">Format of the length prefix</param>
+		/// <exception cref="runtime_error">Occurs if the prefix width is not between 1 and 8</exception>
+		Unix_Frame_Sender(int fd, const Length_Prefix &prefix = {});
+
+		/// <summary>
+		/// Queues a frame to be sent by the next flush() without copying it.
+		/// </summary>
+		/// <param name="data">Pointer to the first byte of the frame, which must stay valid until it is sent</param>
+		/// <param name="size">Size of the frame</param>
+		/// <exception cref="runtime_error">Occurs if <paramref name="size"/> doesn't fit in the length prefix</exception>
+		/// <returns>Reference to the sender object (allows chaining methods)</returns>
+		Unix_Frame_Sender &queue(const unsigned char *data, size_t size);
+
+		/// <summary>
+		/// Queues the buffer of <paramref name="serializer"/> as a frame without copying it.
+		/// <para>The serializer must not be changed or destroyed until the frame is sent.</para>
+		/// </summary>
+		/// <param name="serializer">Serializer holding the frame</param>
+		/// <exception cref="runtime_error">Occurs if the buffer doesn't fit in the length prefix</exception>
+		/// <returns>Reference to the sender object (allows chaining methods)</returns>
+		Unix_Frame_Sender &queue(Serializer &serializer);
+
+		/// <summary>
+		/// Sends the queued frames, gathering length prefixes and payloads into as few sendmsg calls as possible.
+		/// <para>On a non-blocking socket it stops when the socket is full, keeping the rest queued for the next call.</para>
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if sendmsg fails</exception>
+		/// <returns>Amount of frames completely sent by this call</returns>
+		size_t flush();
+
+		/// <summary>
+		/// Get the amount of frames not completely sent yet.
+		/// </summary>
+		/// <returns>Amount of queued frames</returns>
+		size_t get_pending_count() const;
+
+	private:
+		struct Pending_Frame
+		{
+			const unsigned char *data;
+			size_t size;
+			unsigned char prefix[8];
+		};
+
+		int fd;
+		Length_Prefix prefix;
+
+		std::vector<Pending_Frame> pending;
+		size_t first_pending = 0;
+		size_t sent_of_first = 0;
+	};
+
+	class Unix_Frame_Receiver
+	{
+	public:
+		/// <summary>
+		/// Constructs a receiver reading length-prefixed frames from the stream socket <paramref name="fd"/> (POSIX only).
+		/// </summary>
+		/// <param name="fd">Connected stream socket, not owned by the receiver</param>
+		/// <param name="capacity">Initial size of the receive buffer, which grows if a frame doesn't fit</param>
+		/// <param name="prefix">Format of the length prefix</param>
+		/// <param name="max_frame_size">Largest frame accepted, so a peer can't make the receive buffer grow without bound</param>
+		/// <exception cref="runtime_error">Occurs if the prefix width is not between 1 and 8</exception>
+		Unix_Frame_Receiver(int fd, size_t capacity = 256 * 1024, const Length_Prefix &prefix = {}, size_t max_frame_size = 64 * 1024 * 1024);
+
+		/// <summary>
+		/// Reads as many bytes as available (up to the free space of the buffer) with a single recvmsg.
+		/// <para>Invalidates the views handed out by next().</para>
+		/// </summary>
+		/// <exception cref="runtime_error">Occurs if recvmsg fails or the next frame is larger than max_frame_size</exception>
+		/// <returns>Amount of bytes received (0 when the peer closed the connection or a non-blocking socket has no data)</returns>
+		size_t receive();
+
+		/// <summary>
+		/// Get the next complete frame already received, without copying it.
+		/// </summary>
+		/// <param name="frame">Receives a non-owning view over the frame, valid until the next receive() call</param>
+		/// <exception cref="runtime_error">Occurs if the next frame is larger than max_frame_size</exception>
+		/// <returns>false if no complete frame is buffered</returns>
+		bool next(Deserializer &frame);
+
+		/// <summary>
+		/// Receives once and hands every complete frame to <paramref name="handler"/>.
+		/// </summary>
+		/// <param name="handler">Called with a view over each frame</param>
+		/// <exception cref="runtime_error">Occurs if recvmsg fails or a frame is larger than max_frame_size</exception>
+		/// <returns>Amount of frames handled</returns>
+		size_t poll(const std::function<void(Deserializer &frame)> &handler);
+
+		/// <summary>
+		/// Check whether the peer closed the connection.
+		/// </summary>
+		/// <returns>true after receive() reached the end of the stream</returns>
+		bool is_closed() const;
+
+	private:
+		int fd;
+		Length_Prefix prefix;
+		size_t max_frame_size;
+
+		std::vector<unsigned char> ring;
+		size_t head = 0;
+		size_t tail = 0;
+		bool closed = false;
+
+		size_t read_frame_size(const unsigned char *source) const;
+	};
+}
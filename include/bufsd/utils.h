@@ -2,12 +2,81 @@
 
 #include <vector>
 #include <string>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 
 namespace bufsd
 {
+    /// <summary>
+    /// Byte order used to encode multi-byte numeric values.
+    /// </summary>
+    enum class Endianness
+    {
+        BIG,
+        LITTLE
+    };
+
     std::string make_buffer_string(const std::vector<unsigned char> &buffer);
 
     std::vector<unsigned char> hex_string_to_byte_vector(const std::string &hex_string);
+
+    /// <summary>
+    /// Computes the CRC-32C (Castagnoli) checksum of <paramref name="size"/> bytes starting at <paramref name="data"/>.
+    /// <para>Passing the result of a previous call as <paramref name="crc"/> continues the checksum over more bytes.</para>
+    /// </summary>
+    /// <param name="data">Pointer to the first byte</param>
+    /// <param name="size">Amount of bytes</param>
+    /// <param name="crc">Checksum of the preceding bytes (0 to start a new checksum)</param>
+    /// <returns>The checksum</returns>
+    unsigned int crc32c(const unsigned char *data, size_t size, unsigned int crc = 0);
+
+    /// <summary>
+    /// Writes the <paramref name="number_of_bytes"/> lowest bytes of <paramref name="value"/> to <paramref name="destination"/> using <paramref name="endianness"/> order.
+    /// </summary>
+    /// <param name="destination">Where the bytes will be written (must have room for <paramref name="number_of_bytes"/> bytes)</param>
+    /// <param name="value">Value to be written</param>
+    /// <param name="number_of_bytes">Amount of bytes to write (up to 8)</param>
+    /// <param name="endianness">Byte order of the written value</param>
+    inline void write_integer(unsigned char *destination, unsigned long long value, size_t number_of_bytes, Endianness endianness)
+    {
+        for (size_t i = 0; i < number_of_bytes; i++)
+        {
+            size_t shift = endianness == Endianness::BIG ? number_of_bytes - 1 - i : i;
+            destination[i] = (value >> (shift * 8)) & 0xff;
+        }
+    }
+
+    /// <summary>
+    /// Reads a <paramref name="number_of_bytes"/> bytes value from <paramref name="source"/> using <paramref name="endianness"/> order.
+    /// </summary>
+    /// <param name="source">Where the bytes will be read from</param>
+    /// <param name="number_of_bytes">Amount of bytes to read (up to 8)</param>
+    /// <param name="endianness">Byte order of the stored value</param>
+    /// <returns>The decoded value</returns>
+    inline unsigned long long read_integer(const unsigned char *source, size_t number_of_bytes, Endianness endianness)
+    {
+        unsigned long long value = 0;
+
+        for (size_t i = 0; i < number_of_bytes; i++)
+        {
+            size_t shift = endianness == Endianness::BIG ? number_of_bytes - 1 - i : i;
+            value |= (unsigned long long)source[i] << (shift * 8);
+        }
+
+        return value;
+    }
+
+    /// <summary>
+    /// Get the byte order of the machine running the program, folded to a constant by the compiler.
+    /// </summary>
+    /// <returns>Byte order of the host</returns>
+    inline Endianness get_host_endianness()
+    {
+        const unsigned short probe = 1;
+        unsigned char first_byte;
+        std::memcpy(&first_byte, &probe, 1);
+
+        return first_byte == 1 ? Endianness::LITTLE : Endianness::BIG;
+    }
 }
@@ -0,0 +1,757 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <deque>
+#include <cstdint>
+#include <mutex>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <condition_variable>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define BUFSD_HAS_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "bufsd/async_file.h"
+
+namespace bufsd
+{
+	class Async_Io_Backend
+	{
+	public:
+		virtual ~Async_Io_Backend() = default;
+
+		// Starts a read or write of a registered chunk, tagged so its completion can be matched
+		virtual void submit(size_t tag, bool write, unsigned char *data, size_t size, unsigned long long offset) = 0;
+
+		// Blocks until any submitted operation completes; result is the amount of bytes or -errno
+		virtual void wait(size_t &tag, long &result) = 0;
+
+		virtual Async_Backend get_type() const = 0;
+	};
+
+#ifdef BUFSD_HAS_IO_URING
+	class Io_Uring_Backend : public Async_Io_Backend
+	{
+	public:
+		Io_Uring_Backend(int fd, const std::vector<struct iovec> &buffers)
+			: file_fd(fd)
+		{
+			struct io_uring_params params;
+			std::memset(&params, 0, sizeof(params));
+
+			this->ring_fd = (int)::syscall(__NR_io_uring_setup, (unsigned int)buffers.size(), &params);
+			if (this->ring_fd < 0)
+				throw std::runtime_error(std::string("Could not set up io_uring: ") + std::strerror(errno));
+
+			this->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+			this->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+			if (params.features & IORING_FEAT_SINGLE_MMAP)
+				this->sq_size = this->cq_size = std::max(this->sq_size, this->cq_size);
+
+			this->sq_ring = ::mmap(nullptr, this->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ring_fd, IORING_OFF_SQ_RING);
+			if (this->sq_ring == MAP_FAILED)
+				this->fail("Could not map io_uring submission queue");
+
+			if (params.features & IORING_FEAT_SINGLE_MMAP)
+			{
+				this->cq_ring = this->sq_ring;
+			}
+			else
+			{
+				this->cq_ring = ::mmap(nullptr, this->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ring_fd, IORING_OFF_CQ_RING);
+				if (this->cq_ring == MAP_FAILED)
+					this->fail("Could not map io_uring completion queue");
+			}
+
+			this->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+			void *sqes = ::mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ring_fd, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED)
+				this->fail("Could not map io_uring submission entries");
+			this->sqes = static_cast<struct io_uring_sqe *>(sqes);
+
+			unsigned char *sq = static_cast<unsigned char *>(this->sq_ring);
+			this->sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+			this->sq_mask = *reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+			this->sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+
+			unsigned char *cq = static_cast<unsigned char *>(this->cq_ring);
+			this->cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+			this->cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+			this->cq_mask = *reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+			this->cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+			// Registered buffers save the kernel from pinning the pages on every operation; RLIMIT_MEMLOCK may forbid them
+			this->fixed = ::syscall(__NR_io_uring_register, this->ring_fd, IORING_REGISTER_BUFFERS, buffers.data(), (unsigned int)buffers.size()) == 0;
+		}
+
+		~Io_Uring_Backend() override
+		{
+			this->release();
+		}
+
+		void submit(size_t tag, bool write, unsigned char *data, size_t size, unsigned long long offset) override
+		{
+			unsigned int tail = *this->sq_tail;
+			unsigned int index = tail & this->sq_mask;
+
+			struct io_uring_sqe *sqe = &this->sqes[index];
+			std::memset(sqe, 0, sizeof(*sqe));
+
+			if (this->fixed)
+			{
+				sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+				sqe->buf_index = (unsigned short)tag;
+			}
+			else
+			{
+				sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+			}
+
+			sqe->fd = this->file_fd;
+			sqe->addr = (unsigned long long)(uintptr_t)data;
+			sqe->len = (unsigned int)size;
+			sqe->off = offset;
+			sqe->user_data = tag;
+
+			this->sq_array[index] = index;
+			__atomic_store_n(this->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+			while (::syscall(__NR_io_uring_enter, this->ring_fd, 1, 0, 0, nullptr, 0) < 0)
+			{
+				if (errno != EINTR && errno != EAGAIN)
+					throw std::runtime_error(std::string("Could not submit to io_uring: ") + std::strerror(errno));
+			}
+		}
+
+		void wait(size_t &tag, long &result) override
+		{
+			while (true)
+			{
+				unsigned int head = *this->cq_head;
+
+				if (head != __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE))
+				{
+					struct io_uring_cqe *cqe = &this->cqes[head & this->cq_mask];
+					tag = (size_t)cqe->user_data;
+					result = cqe->res;
+
+					__atomic_store_n(this->cq_head, head + 1, __ATOMIC_RELEASE);
+					return;
+				}
+
+				if (::syscall(__NR_io_uring_enter, this->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+					throw std::runtime_error(std::string("Could not wait for io_uring: ") + std::strerror(errno));
+			}
+		}
+
+		Async_Backend get_type() const override
+		{
+			return Async_Backend::IO_URING;
+		}
+
+	private:
+		int file_fd;
+		int ring_fd = -1;
+		bool fixed = false;
+
+		void *sq_ring = MAP_FAILED;
+		void *cq_ring = MAP_FAILED;
+		size_t sq_size = 0;
+		size_t cq_size = 0;
+		struct io_uring_sqe *sqes = nullptr;
+		size_t sqes_size = 0;
+
+		unsigned int *sq_tail = nullptr;
+		unsigned int sq_mask = 0;
+		unsigned int *sq_array = nullptr;
+		unsigned int *cq_head = nullptr;
+		unsigned int *cq_tail = nullptr;
+		unsigned int cq_mask = 0;
+		struct io_uring_cqe *cqes = nullptr;
+
+		void release()
+		{
+			if (this->sqes)
+				::munmap(this->sqes, this->sqes_size);
+			if (this->cq_ring != MAP_FAILED && this->cq_ring != this->sq_ring)
+				::munmap(this->cq_ring, this->cq_size);
+			if (this->sq_ring != MAP_FAILED)
+				::munmap(this->sq_ring, this->sq_size);
+			if (this->ring_fd >= 0)
+				::close(this->ring_fd);
+		}
+
+		[[noreturn]] void fail(const char *message)
+		{
+			int error = errno;
+			this->release();
+			throw std::runtime_error(std::string(message) + ": " + std::strerror(error));
+		}
+	};
+#endif
+
+	class Thread_Pool_Backend : public Async_Io_Backend
+	{
+	public:
+		Thread_Pool_Backend(int fd, unsigned int worker_count)
+			: fd(fd)
+		{
+			for (unsigned int i = 0; i < std::max(worker_count, 1u); i++)
+				this->workers.emplace_back(&Thread_Pool_Backend::work, this);
+		}
+
+		~Thread_Pool_Backend() override
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->stopping = true;
+			}
+
+			this->request_ready.notify_all();
+
+			for (std::thread &worker : this->workers)
+				worker.join();
+		}
+
+		void submit(size_t tag, bool write, unsigned char *data, size_t size, unsigned long long offset) override
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->requests.push_back({tag, write, data, size, offset});
+			}
+
+			this->request_ready.notify_one();
+		}
+
+		void wait(size_t &tag, long &result) override
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->completion_ready.wait(lock, [this] { return !this->completions.empty(); });
+
+			tag = this->completions.front().first;
+			result = this->completions.front().second;
+			this->completions.pop_front();
+		}
+
+		Async_Backend get_type() const override
+		{
+			return Async_Backend::THREAD_POOL;
+		}
+
+	private:
+		struct Request
+		{
+			size_t tag;
+			bool write;
+			unsigned char *data;
+			size_t size;
+			unsigned long long offset;
+		};
+
+		int fd;
+		std::mutex mutex;
+		std::condition_variable request_ready;
+		std::condition_variable completion_ready;
+		std::deque<Request> requests;
+		std::deque<std::pair<size_t, long>> completions;
+		std::vector<std::thread> workers;
+		bool stopping = false;
+
+		void work()
+		{
+			while (true)
+			{
+				Request request;
+
+				{
+					std::unique_lock<std::mutex> lock(this->mutex);
+					this->request_ready.wait(lock, [this] { return this->stopping || !this->requests.empty(); });
+
+					if (this->requests.empty())
+						return;
+
+					request = this->requests.front();
+					this->requests.pop_front();
+				}
+
+				ssize_t result;
+				do
+				{
+					result = request.write
+						? ::pwrite(this->fd, request.data, request.size, (off_t)request.offset)
+						: ::pread(this->fd, request.data, request.size, (off_t)request.offset);
+				} while (result < 0 && errno == EINTR);
+
+				{
+					std::lock_guard<std::mutex> lock(this->mutex);
+					this->completions.emplace_back(request.tag, result < 0 ? -(long)errno : (long)result);
+				}
+
+				this->completion_ready.notify_one();
+			}
+		}
+	};
+
+	static std::unique_ptr<Async_Io_Backend> make_backend(int fd, const Async_File_Options &options, const std::vector<struct iovec> &buffers)
+	{
+#ifdef BUFSD_HAS_IO_URING
+		if (options.backend != Async_Backend::THREAD_POOL)
+		{
+			try
+			{
+				return std::unique_ptr<Async_Io_Backend>(new Io_Uring_Backend(fd, buffers));
+			}
+			catch (const std::runtime_error &)
+			{
+				if (options.backend == Async_Backend::IO_URING)
+					throw;
+			}
+		}
+#else
+		if (options.backend == Async_Backend::IO_URING)
+			throw std::runtime_error("io_uring is not available on this platform");
+#endif
+
+		return std::unique_ptr<Async_Io_Backend>(new Thread_Pool_Backend(fd, options.worker_count));
+	}
+
+	Async_File_Sink::Async_File_Sink(const std::string &path, const Async_File_Options &options)
+		: chunk_size(options.chunk_size > 0 ? options.chunk_size : 1024 * 1024), chunks(std::max(options.queue_depth, 1u))
+	{
+		this->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (this->fd < 0)
+			throw std::runtime_error("Could not open \"" + path + "\": " + std::strerror(errno));
+
+		std::vector<struct iovec> buffers(this->chunks.size());
+		for (size_t i = 0; i < this->chunks.size(); i++)
+		{
+			this->chunks[i].data.reset(new unsigned char[this->chunk_size]);
+			buffers[i].iov_base = this->chunks[i].data.get();
+			buffers[i].iov_len = this->chunk_size;
+		}
+
+		try
+		{
+			this->backend = make_backend(this->fd, options, buffers);
+		}
+		catch (const std::runtime_error &)
+		{
+			::close(this->fd);
+			throw;
+		}
+	}
+
+	Async_File_Sink::~Async_File_Sink()
+	{
+		try
+		{
+			this->close();
+		}
+		catch (const std::runtime_error &)
+		{
+		}
+	}
+
+	Async_File_Sink &Async_File_Sink::write(const unsigned char *data, size_t size)
+	{
+		while (size > 0)
+		{
+			if (!this->has_current)
+			{
+				while (this->in_flight == this->chunks.size())
+					this->wait_one();
+
+				this->current = 0;
+				while (this->chunks[this->current].in_flight)
+					this->current++;
+
+				this->chunks[this->current].size = 0;
+				this->has_current = true;
+			}
+
+			Chunk &chunk = this->chunks[this->current];
+			size_t amount = std::min(size, this->chunk_size - chunk.size);
+
+			std::memcpy(chunk.data.get() + chunk.size, data, amount);
+			chunk.size += amount;
+			data += amount;
+			size -= amount;
+
+			if (chunk.size == this->chunk_size)
+			{
+				this->has_current = false;
+				this->submit(this->current);
+			}
+		}
+
+		return *this;
+	}
+
+	Async_File_Sink &Async_File_Sink::write(Serializer &serializer)
+	{
+		const std::vector<unsigned char> &buffer = serializer.get_buffer();
+
+		return this->write(buffer.data(), buffer.size());
+	}
+
+	Async_File_Sink &Async_File_Sink::write_frame(Serializer &serializer, const Length_Prefix &prefix)
+	{
+		const std::vector<unsigned char> &buffer = serializer.get_buffer();
+
+		unsigned char size[8];
+		prefix.write(size, buffer.size());
+
+		this->write(size, prefix.number_of_bytes);
+
+		return this->write(buffer.data(), buffer.size());
+	}
+
+	void Async_File_Sink::flush()
+	{
+		if (this->has_current)
+		{
+			this->has_current = false;
+
+			if (this->chunks[this->current].size > 0)
+				this->submit(this->current);
+		}
+
+		while (this->in_flight > 0)
+			this->wait_one();
+	}
+
+	void Async_File_Sink::close()
+	{
+		if (this->fd < 0)
+			return;
+
+		std::string error;
+
+		try
+		{
+			this->flush();
+		}
+		catch (const std::runtime_error &exception)
+		{
+			error = exception.what();
+		}
+
+		// The chunks must not be freed while the kernel may still write from them
+		while (this->in_flight > 0)
+		{
+			try
+			{
+				this->wait_one();
+			}
+			catch (const std::runtime_error &)
+			{
+			}
+		}
+
+		::close(this->fd);
+		this->fd = -1;
+
+		if (!error.empty())
+			throw std::runtime_error(error);
+	}
+
+	unsigned long long Async_File_Sink::get_size() const
+	{
+		return this->offset + (this->has_current ? this->chunks[this->current].size : 0);
+	}
+
+	Async_Backend Async_File_Sink::get_backend() const
+	{
+		return this->backend->get_type();
+	}
+
+	void Async_File_Sink::submit(size_t chunk)
+	{
+		Chunk &submitted = this->chunks[chunk];
+		submitted.offset = this->offset;
+		submitted.done = 0;
+
+		this->backend->submit(chunk, true, submitted.data.get(), submitted.size, submitted.offset);
+
+		this->offset += submitted.size;
+		submitted.in_flight = true;
+		this->in_flight++;
+	}
+
+	void Async_File_Sink::wait_one()
+	{
+		size_t tag;
+		long result;
+		this->backend->wait(tag, result);
+
+		Chunk &chunk = this->chunks[tag];
+
+		if (result > 0 && chunk.done + (size_t)result < chunk.size)
+		{
+			chunk.done += (size_t)result;
+
+			try
+			{
+				this->backend->submit(tag, true, chunk.data.get() + chunk.done, chunk.size - chunk.done, chunk.offset + chunk.done);
+				return;
+			}
+			catch (const std::runtime_error &)
+			{
+				chunk.in_flight = false;
+				this->in_flight--;
+				throw;
+			}
+		}
+
+		chunk.in_flight = false;
+		this->in_flight--;
+
+		if (result < 0)
+			throw std::runtime_error("Could not write " + std::to_string(chunk.size) + " bytes at offset " + std::to_string(chunk.offset) + ": " + std::strerror((int)-result));
+
+		if (result == 0)
+			throw std::runtime_error("Could not write " + std::to_string(chunk.size) + " bytes at offset " + std::to_string(chunk.offset) + ": no progress");
+	}
+
+	Async_File_Source::Async_File_Source(const std::string &path, const Async_File_Options &options, const Length_Prefix &prefix)
+		: chunk_size(options.chunk_size > 0 ? options.chunk_size : 1024 * 1024), prefix(prefix), chunks(std::max(options.queue_depth, 1u))
+	{
+		this->prefix.validate();
+
+		this->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (this->fd < 0)
+			throw std::runtime_error("Could not open \"" + path + "\": " + std::strerror(errno));
+
+		struct stat status;
+		if (::fstat(this->fd, &status) != 0)
+		{
+			int error = errno;
+			::close(this->fd);
+			throw std::runtime_error("Could not stat \"" + path + "\": " + std::strerror(error));
+		}
+
+		this->file_size = (unsigned long long)status.st_size;
+
+		std::vector<struct iovec> buffers(this->chunks.size());
+		for (size_t i = 0; i < this->chunks.size(); i++)
+		{
+			this->chunks[i].data.reset(new unsigned char[this->chunk_size]);
+			buffers[i].iov_base = this->chunks[i].data.get();
+			buffers[i].iov_len = this->chunk_size;
+		}
+
+		try
+		{
+			this->backend = make_backend(this->fd, options, buffers);
+
+			for (size_t i = 0; i < this->chunks.size() && this->next_read_offset < this->file_size; i++)
+				this->submit(i);
+		}
+		catch (const std::runtime_error &)
+		{
+			this->release();
+			throw;
+		}
+	}
+
+	Async_File_Source::~Async_File_Source()
+	{
+		this->release();
+	}
+
+	bool Async_File_Source::next_chunk(const unsigned char *&data, size_t &size)
+	{
+		if (!this->pull_chunk())
+			return false;
+
+		data = this->chunk_data;
+		size = this->chunk_remaining;
+		this->chunk_remaining = 0;
+
+		return true;
+	}
+
+	bool Async_File_Source::next(Deserializer &frame)
+	{
+		const size_t prefix_size = this->prefix.number_of_bytes;
+
+		if (this->chunk_remaining == 0 && !this->pull_chunk())
+			return false;
+
+		if (this->chunk_remaining >= prefix_size)
+		{
+			size_t size = this->prefix.read(this->chunk_data);
+
+			if (this->chunk_remaining - prefix_size >= size)
+			{
+				frame = Deserializer(this->chunk_data + prefix_size, size);
+				this->chunk_data += prefix_size + size;
+				this->chunk_remaining -= prefix_size + size;
+
+				return true;
+			}
+		}
+
+		// The frame crosses the end of the chunk, so it is copied together
+		const Chunk &chunk = this->chunks[this->current];
+		const unsigned long long frame_offset = chunk.offset + (unsigned long long)(this->chunk_data - chunk.data.get());
+
+		this->assembly.clear();
+
+		if (!this->append_to_assembly(prefix_size))
+			throw std::runtime_error("File ends in the middle of a length prefix");
+
+		size_t size = this->prefix.read(this->assembly.data());
+
+		// A forged 8 bytes prefix would otherwise wrap prefix_size + size around
+		if (!this->prefix.fits(size, this->file_size - frame_offset) || !this->append_to_assembly(prefix_size + size))
+			throw std::runtime_error("File ends in the middle of a frame of " + std::to_string(size) + " bytes");
+
+		frame = Deserializer(this->assembly.data() + prefix_size, size);
+
+		return true;
+	}
+
+	unsigned long long Async_File_Source::get_file_size() const
+	{
+		return this->file_size;
+	}
+
+	Async_Backend Async_File_Source::get_backend() const
+	{
+		return this->backend->get_type();
+	}
+
+	void Async_File_Source::submit(size_t chunk)
+	{
+		Chunk &submitted = this->chunks[chunk];
+		submitted.offset = this->next_read_offset;
+		submitted.size = (size_t)std::min<unsigned long long>(this->chunk_size, this->file_size - this->next_read_offset);
+		submitted.done = 0;
+
+		this->backend->submit(chunk, false, submitted.data.get(), submitted.size, submitted.offset);
+
+		this->next_read_offset += submitted.size;
+		submitted.in_flight = true;
+	}
+
+	void Async_File_Source::wait_one()
+	{
+		size_t tag;
+		long result;
+		this->backend->wait(tag, result);
+
+		Chunk &chunk = this->chunks[tag];
+
+		if (result > 0 && chunk.done + (size_t)result < chunk.size)
+		{
+			chunk.done += (size_t)result;
+
+			try
+			{
+				this->backend->submit(tag, false, chunk.data.get() + chunk.done, chunk.size - chunk.done, chunk.offset + chunk.done);
+				return;
+			}
+			catch (const std::runtime_error &)
+			{
+				chunk.in_flight = false;
+				throw;
+			}
+		}
+
+		chunk.in_flight = false;
+
+		if (result < 0)
+			throw std::runtime_error("Could not read " + std::to_string(chunk.size) + " bytes at offset " + std::to_string(chunk.offset) + ": " + std::strerror((int)-result));
+
+		if (result == 0)
+			throw std::runtime_error("File ended at offset " + std::to_string(chunk.offset + chunk.done) + " while reading");
+	}
+
+	bool Async_File_Source::pull_chunk()
+	{
+		// Chunk n of the file always lands in buffer n % queue_depth, so finishing with a buffer means prefetching queue_depth chunks ahead
+		if (this->has_current)
+		{
+			this->has_current = false;
+
+			if (this->next_read_offset < this->file_size)
+				this->submit(this->current);
+		}
+
+		if (this->next_chunk_number * this->chunk_size >= this->file_size)
+			return false;
+
+		this->current = (size_t)(this->next_chunk_number % this->chunks.size());
+
+		while (this->chunks[this->current].in_flight)
+			this->wait_one();
+
+		this->has_current = true;
+		this->next_chunk_number++;
+		this->chunk_data = this->chunks[this->current].data.get();
+		this->chunk_remaining = this->chunks[this->current].size;
+
+		return true;
+	}
+
+	void Async_File_Source::release()
+	{
+		if (this->fd < 0)
+			return;
+
+		// The chunks must not be freed while the kernel may still read into them
+		for (size_t i = 0; this->backend && i < this->chunks.size(); i++)
+		{
+			while (this->chunks[i].in_flight)
+			{
+				try
+				{
+					this->wait_one();
+				}
+				catch (const std::runtime_error &)
+				{
+				}
+			}
+		}
+
+		this->backend.reset();
+		::close(this->fd);
+		this->fd = -1;
+	}
+
+	bool Async_File_Source::append_to_assembly(size_t size)
+	{
+		while (this->assembly.size() < size)
+		{
+			if (this->chunk_remaining == 0)
+			{
+				if (!this->pull_chunk())
+					return false;
+
+				continue;
+			}
+
+			size_t amount = std::min(size - this->assembly.size(), this->chunk_remaining);
+			this->assembly.insert(this->assembly.end(), this->chunk_data, this->chunk_data + amount);
+			this->chunk_data += amount;
+			this->chunk_remaining -= amount;
+		}
+
+		return true;
+	}
+}
+
+#endif
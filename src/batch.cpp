@@ -0,0 +1,178 @@
+#include <stdexcept>
+
+#include "bufsd/batch.h"
+
+namespace bufsd
+{
+	Batch_Builder::Batch_Builder(const Batch_Flush_Policy &policy)
+		: policy(policy)
+	{
+	}
+
+	Batch_Builder &Batch_Builder::add(const unsigned char *message, size_t size)
+	{
+		// The limit applies to the whole envelope, since its size field and every offset are 32 bits
+		unsigned long long encoded_size = BATCH_HEADER_SIZE + (this->ends.size() + 1) * 4ULL + this->payloads.size() + size;
+
+		if (size > 0xffffffff || encoded_size > 0xffffffff)
+			throw std::runtime_error("Batch envelopes are limited to 4 GiB, adding a message of " + std::to_string(size) + " byte(s) would make it " + std::to_string(encoded_size) + " byte(s)");
+
+		if (this->ends.empty())
+			this->first_message_time = std::chrono::steady_clock::now();
+
+		this->payloads.insert(this->payloads.end(), message, message + size);
+		this->ends.push_back((unsigned int)this->payloads.size());
+
+		return *this;
+	}
+
+	Batch_Builder &Batch_Builder::add(const std::vector<unsigned char> &message)
+	{
+		return this->add(message.data(), message.size());
+	}
+
+	Batch_Builder &Batch_Builder::add(const Serializable &object)
+	{
+		return this->add(object.serialize());
+	}
+
+	bool Batch_Builder::should_flush() const
+	{
+		if (this->ends.empty())
+			return false;
+
+		return this->payloads.size() >= this->policy.max_bytes ||
+			   this->ends.size() >= this->policy.max_messages ||
+			   std::chrono::steady_clock::now() - this->first_message_time >= this->policy.max_latency;
+	}
+
+	const std::vector<unsigned char> &Batch_Builder::finish()
+	{
+		this->envelope.clear()
+			.defer_buffer_size_32_big_endian()
+			.push_32_big_endian((unsigned int)this->ends.size());
+
+		size_t table = this->envelope.push_placeholder(this->ends.size() * 4);
+		this->envelope.push_buffer(this->payloads);
+
+		for (size_t message = 0; message < this->ends.size(); message++)
+			this->envelope.patch_big_endian(table + message * 4, this->ends[message]);
+
+		this->payloads.clear();
+		this->ends.clear();
+
+		return this->envelope.get_buffer();
+	}
+
+	size_t Batch_Builder::get_message_count() const
+	{
+		return this->ends.size();
+	}
+
+	bool Batch_Builder::empty() const
+	{
+		return this->ends.empty();
+	}
+
+	Batch_Reader::Iterator::Iterator(const Batch_Reader *reader, size_t message)
+		: reader(reader), message(message)
+	{
+	}
+
+	Deserializer Batch_Reader::Iterator::operator*() const
+	{
+		return this->reader->get_message(this->message);
+	}
+
+	Batch_Reader::Iterator &Batch_Reader::Iterator::operator++()
+	{
+		this->message++;
+		return *this;
+	}
+
+	bool Batch_Reader::Iterator::operator==(const Iterator &other) const
+	{
+		return this->reader == other.reader && this->message == other.message;
+	}
+
+	bool Batch_Reader::Iterator::operator!=(const Iterator &other) const
+	{
+		return !(*this == other);
+	}
+
+	Batch_Reader::Batch_Reader(const unsigned char *data, size_t size)
+	{
+		this->parse(data, size);
+	}
+
+	Batch_Reader::Batch_Reader(Deserializer &deserializer)
+	{
+		const unsigned char *data = deserializer.get_data() + deserializer.get_cursor();
+
+		this->parse(data, deserializer.get_remaining());
+		deserializer.skip(this->batch_size);
+	}
+
+	size_t Batch_Reader::get_message_count() const
+	{
+		return this->message_count;
+	}
+
+	size_t Batch_Reader::get_batch_size() const
+	{
+		return this->batch_size;
+	}
+
+	Deserializer Batch_Reader::get_message(size_t message) const
+	{
+		if (message >= this->message_count)
+			throw std::runtime_error("Message " + std::to_string(message) + " doesn't exist, the batch has " + std::to_string(this->message_count) + " message(s)");
+
+		size_t begin = message == 0 ? 0 : this->end_of(message - 1);
+
+		return Deserializer(this->payloads + begin, this->end_of(message) - begin);
+	}
+
+	Batch_Reader::Iterator Batch_Reader::begin() const
+	{
+		return Iterator(this, 0);
+	}
+
+	Batch_Reader::Iterator Batch_Reader::end() const
+	{
+		return Iterator(this, this->message_count);
+	}
+
+	void Batch_Reader::parse(const unsigned char *data, size_t size)
+	{
+		if (size < BATCH_HEADER_SIZE)
+			throw std::runtime_error("Batch envelope is truncated");
+
+		this->batch_size = (size_t)read_integer(data, 4, Endianness::BIG);
+		this->message_count = (size_t)read_integer(data + 4, 4, Endianness::BIG);
+
+		if (this->batch_size > size || this->batch_size < BATCH_HEADER_SIZE ||
+			(this->batch_size - BATCH_HEADER_SIZE) / 4 < this->message_count)
+			throw std::runtime_error("Batch envelope is truncated");
+
+		this->offsets = data + BATCH_HEADER_SIZE;
+		this->payloads = this->offsets + this->message_count * 4;
+
+		size_t payloads_size = this->batch_size - BATCH_HEADER_SIZE - this->message_count * 4;
+		size_t previous = 0;
+
+		for (size_t message = 0; message < this->message_count; message++)
+		{
+			size_t end = this->end_of(message);
+			if (end < previous || end > payloads_size)
+				throw std::runtime_error("Batch envelope has an invalid offset table");
+
+			previous = end;
+		}
+	}
+
+	size_t Batch_Reader::end_of(size_t message) const
+	{
+		return (size_t)read_integer(this->offsets + message * 4, 4, Endianness::BIG);
+	}
+}
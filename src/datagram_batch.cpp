@@ -0,0 +1,173 @@
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/uio.h>
+
+#include "bufsd/datagram_batch.h"
+
+namespace bufsd
+{
+	Datagram_Batch_Sender::Datagram_Batch_Sender(int fd, size_t capacity)
+		: fd(fd), slots(capacity > 0 ? capacity : 1), iovecs(this->slots.size()), messages(this->slots.size())
+	{
+		for (size_t i = 0; i < this->slots.size(); i++)
+		{
+			std::memset(&this->messages[i], 0, sizeof(this->messages[i]));
+			this->messages[i].msg_hdr.msg_iov = &this->iovecs[i];
+			this->messages[i].msg_hdr.msg_iovlen = 1;
+		}
+	}
+
+	Datagram_Batch_Sender::~Datagram_Batch_Sender()
+	{
+	}
+
+	Serializer &Datagram_Batch_Sender::next_slot()
+	{
+		if (this->used == this->slots.size())
+			throw std::runtime_error("Every one of the " + std::to_string(this->slots.size()) + " datagram slot(s) is already used");
+
+		return this->slots[this->used++].clear();
+	}
+
+	size_t Datagram_Batch_Sender::send(const struct sockaddr *destination, socklen_t destination_length)
+	{
+		// Slot buffers may have been reallocated while serializing, so only their iovecs are refreshed
+		for (size_t i = 0; i < this->used; i++)
+		{
+			const std::vector<unsigned char> &buffer = this->slots[i].get_buffer();
+
+			this->iovecs[i].iov_base = const_cast<unsigned char *>(buffer.data());
+			this->iovecs[i].iov_len = buffer.size();
+
+			this->messages[i].msg_hdr.msg_name = const_cast<struct sockaddr *>(destination);
+			this->messages[i].msg_hdr.msg_namelen = destination ? destination_length : 0;
+		}
+
+		size_t sent = 0;
+
+		while (sent < this->used)
+		{
+			int result = ::sendmmsg(this->fd, this->messages.data() + sent, (unsigned int)(this->used - sent), 0);
+
+			if (result < 0 && errno == EINTR)
+				continue;
+
+			if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				break;
+
+			if (result < 0)
+			{
+				this->used = 0;
+				throw std::runtime_error(std::string("Could not send datagrams: ") + std::strerror(errno));
+			}
+
+			sent += (size_t)result;
+		}
+
+		this->used = 0;
+
+		return sent;
+	}
+
+	size_t Datagram_Batch_Sender::get_datagram_count() const
+	{
+		return this->used;
+	}
+
+	bool Datagram_Batch_Sender::full() const
+	{
+		return this->used == this->slots.size();
+	}
+
+	Datagram_Batch_Receiver::Datagram_Batch_Receiver(int fd, size_t capacity, size_t slot_size)
+		: fd(fd), capacity(capacity > 0 ? capacity : 1), slot_size(slot_size > 0 ? slot_size : 1)
+	{
+		this->storage.resize(this->capacity * this->slot_size);
+		this->sizes.resize(this->capacity, 0);
+		this->truncated.resize(this->capacity, false);
+
+		this->iovecs.resize(this->capacity);
+		this->messages.resize(this->capacity);
+
+		for (size_t i = 0; i < this->capacity; i++)
+		{
+			this->iovecs[i].iov_base = this->storage.data() + i * this->slot_size;
+			this->iovecs[i].iov_len = this->slot_size;
+
+			std::memset(&this->messages[i], 0, sizeof(this->messages[i]));
+			this->messages[i].msg_hdr.msg_iov = &this->iovecs[i];
+			this->messages[i].msg_hdr.msg_iovlen = 1;
+		}
+	}
+
+	Datagram_Batch_Receiver::~Datagram_Batch_Receiver()
+	{
+	}
+
+	size_t Datagram_Batch_Receiver::receive()
+	{
+		this->received = 0;
+
+		while (true)
+		{
+			int result = ::recvmmsg(this->fd, this->messages.data(), (unsigned int)this->capacity, MSG_WAITFORONE, nullptr);
+
+			if (result < 0 && errno == EINTR)
+				continue;
+
+			if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				return 0;
+
+			if (result < 0)
+				throw std::runtime_error(std::string("Could not receive datagrams: ") + std::strerror(errno));
+
+			this->received = (size_t)result;
+			break;
+		}
+
+		for (size_t i = 0; i < this->received; i++)
+		{
+			this->sizes[i] = this->messages[i].msg_len;
+			this->truncated[i] = (this->messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+		}
+
+		return this->received;
+	}
+
+	size_t Datagram_Batch_Receiver::get_datagram_count() const
+	{
+		return this->received;
+	}
+
+	Deserializer Datagram_Batch_Receiver::get_datagram(size_t datagram) const
+	{
+		if (datagram >= this->received)
+			throw std::runtime_error("Datagram " + std::to_string(datagram) + " doesn't exist, the batch has " + std::to_string(this->received) + " datagram(s)");
+
+		return Deserializer(this->storage.data() + datagram * this->slot_size, this->sizes[datagram]);
+	}
+
+	bool Datagram_Batch_Receiver::is_truncated(size_t datagram) const
+	{
+		return datagram < this->received && this->truncated[datagram];
+	}
+
+	size_t Datagram_Batch_Receiver::poll(const std::function<void(Deserializer &datagram)> &handler)
+	{
+		size_t count = this->receive();
+
+		for (size_t i = 0; i < count; i++)
+		{
+			Deserializer datagram = this->get_datagram(i);
+			handler(datagram);
+		}
+
+		return count;
+	}
+}
+
+#endif
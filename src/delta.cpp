@@ -0,0 +1,310 @@
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BUFSD_DELTA_SSE2
+#endif
+
+#include "bufsd/delta.h"
+#include "bufsd/serializer.h"
+
+namespace bufsd
+{
+	static const unsigned char DELTA_COPY = 0x01;
+	static const unsigned char DELTA_LITERAL = 0x02;
+	static const size_t DELTA_HEADER_SIZE = 16;
+	static const size_t MAX_OPERATION_LENGTH = 0xffffffff;
+
+	static size_t common_prefix(const unsigned char *a, const unsigned char *b, size_t length)
+	{
+		size_t i = 0;
+
+#ifdef BUFSD_DELTA_SSE2
+		for (; i + 16 <= length; i += 16)
+		{
+			__m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+			__m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(left, right)) != 0xffff)
+				break;
+		}
+#endif
+
+		for (; i + 8 <= length; i += 8)
+		{
+			uint64_t left, right;
+			std::memcpy(&left, a + i, 8);
+			std::memcpy(&right, b + i, 8);
+
+			if (left != right)
+				break;
+		}
+
+		while (i < length && a[i] == b[i])
+			i++;
+
+		return i;
+	}
+
+	struct Rolling_Hash
+	{
+		uint32_t a = 0;
+		uint32_t b = 0;
+
+		void reset(const unsigned char *window, size_t length)
+		{
+			this->a = 0;
+			this->b = 0;
+
+			for (size_t i = 0; i < length; i++)
+			{
+				this->a += window[i];
+				this->b += (uint32_t)(length - i) * window[i];
+			}
+		}
+
+		void roll(unsigned char out, unsigned char in, size_t length)
+		{
+			this->a += in - out;
+			this->b += this->a - (uint32_t)length * out;
+		}
+
+		uint32_t value() const
+		{
+			return (this->b << 16) ^ this->a;
+		}
+	};
+
+	class Block_Index
+	{
+	public:
+		Block_Index(const std::vector<unsigned char> &base, size_t block_size)
+		{
+			size_t number_of_blocks = base.size() / block_size;
+
+			while (((size_t)1 << this->bits) < number_of_blocks * 2)
+				this->bits++;
+
+			this->slots.assign((size_t)1 << this->bits, 0);
+
+			Rolling_Hash hash;
+			for (size_t block = 0; block < number_of_blocks; block++)
+			{
+				size_t offset = block * block_size;
+				hash.reset(base.data() + offset, block_size);
+
+				size_t &slot = this->slots[this->slot_of(hash.value())];
+				if (slot == 0)
+					slot = offset + 1;
+			}
+		}
+
+		bool find(uint32_t hash, size_t &offset) const
+		{
+			size_t slot = this->slots[this->slot_of(hash)];
+			if (slot == 0)
+				return false;
+
+			offset = slot - 1;
+			return true;
+		}
+
+	private:
+		size_t slot_of(uint32_t hash) const
+		{
+			return (size_t)((hash * 2654435761u) >> (32 - this->bits));
+		}
+
+	private:
+		unsigned int bits = 4;
+		std::vector<size_t> slots;
+	};
+
+	static void push_copy(Serializer &serializer, size_t offset, size_t length)
+	{
+		while (length > 0)
+		{
+			size_t chunk = length < MAX_OPERATION_LENGTH ? length : MAX_OPERATION_LENGTH;
+
+			serializer.push_byte(DELTA_COPY)
+				.push_64_big_endian((unsigned long long)offset)
+				.push_32_big_endian((unsigned int)chunk);
+
+			offset += chunk;
+			length -= chunk;
+		}
+	}
+
+	static void push_literal(Serializer &serializer, const unsigned char *data, size_t length)
+	{
+		while (length > 0)
+		{
+			size_t chunk = length < MAX_OPERATION_LENGTH ? length : MAX_OPERATION_LENGTH;
+
+			serializer.push_byte(DELTA_LITERAL)
+				.push_32_big_endian((unsigned int)chunk)
+				.push_buffer(data, chunk);
+
+			data += chunk;
+			length -= chunk;
+		}
+	}
+
+	std::vector<unsigned char> make_delta(const std::vector<unsigned char> &base, const std::vector<unsigned char> &target, const Delta_Options &options)
+	{
+		if (options.block_size == 0 || options.min_match == 0)
+			throw std::runtime_error("Delta block size and minimum match must be greater than 0");
+
+		const size_t block_size = options.block_size;
+		const size_t base_size = base.size();
+		const size_t target_size = target.size();
+		const size_t aligned_size = base_size < target_size ? base_size : target_size;
+
+		Serializer serializer;
+		serializer.push_64_big_endian((unsigned long long)base_size)
+			.push_64_big_endian((unsigned long long)target_size);
+
+		std::unique_ptr<Block_Index> index;
+		Rolling_Hash hash;
+		size_t hash_position = 0;
+		bool hash_valid = false;
+
+		size_t position = 0;
+		size_t literal_start = 0;
+
+		while (position < target_size)
+		{
+			if (position < aligned_size)
+			{
+				size_t run = common_prefix(base.data() + position, target.data() + position, aligned_size - position);
+
+				if (run >= options.min_match)
+				{
+					push_literal(serializer, target.data() + literal_start, position - literal_start);
+					push_copy(serializer, position, run);
+
+					position += run;
+					literal_start = position;
+					continue;
+				}
+			}
+
+			if (base_size >= block_size && target_size - position >= block_size)
+			{
+				if (!index)
+					index.reset(new Block_Index(base, block_size));
+
+				// The hash can only roll from the window right before this one, anything else is recomputed
+				if (hash_valid && hash_position + 1 == position)
+					hash.roll(target[position - 1], target[position - 1 + block_size], block_size);
+				else if (!hash_valid || hash_position != position)
+					hash.reset(target.data() + position, block_size);
+				hash_position = position;
+				hash_valid = true;
+
+				size_t offset;
+				if (index->find(hash.value(), offset) && std::memcmp(base.data() + offset, target.data() + position, block_size) == 0)
+				{
+					size_t extension = (base_size - offset - block_size) < (target_size - position - block_size)
+										   ? base_size - offset - block_size
+										   : target_size - position - block_size;
+					size_t length = block_size + common_prefix(base.data() + offset + block_size, target.data() + position + block_size, extension);
+
+					push_literal(serializer, target.data() + literal_start, position - literal_start);
+					push_copy(serializer, offset, length);
+
+					position += length;
+					literal_start = position;
+					continue;
+				}
+			}
+
+			position++;
+		}
+
+		push_literal(serializer, target.data() + literal_start, target_size - literal_start);
+
+		return serializer.get_buffer();
+	}
+
+	static void assert_delta_has(size_t cursor, size_t amount_of_bytes, size_t delta_size)
+	{
+		if (delta_size - cursor < amount_of_bytes)
+			throw std::runtime_error("Malformed delta: operation goes beyond the end of the delta");
+	}
+
+	void apply_delta(const std::vector<unsigned char> &base, const std::vector<unsigned char> &delta, std::vector<unsigned char> &output)
+	{
+		const unsigned char *data = delta.data();
+		const size_t delta_size = delta.size();
+
+		assert_delta_has(0, DELTA_HEADER_SIZE, delta_size);
+
+		unsigned long long base_size = read_integer(data, 8, Endianness::BIG);
+		unsigned long long target_size = read_integer(data + 8, 8, Endianness::BIG);
+
+		if (base_size != base.size())
+			throw std::runtime_error("Delta was created from a " + std::to_string(base_size) + " byte(s) base, but the given base has " + std::to_string(base.size()) + " byte(s)");
+
+		// target_size comes from the delta itself, so the output grows as operations are validated
+		// rather than being sized up front; the reservation is capped by what a typical delta rebuilds
+		output.clear();
+		output.reserve(target_size < base.size() + delta_size ? (size_t)target_size : base.size() + delta_size);
+
+		size_t cursor = DELTA_HEADER_SIZE;
+		size_t written = 0;
+
+		while (cursor < delta_size)
+		{
+			unsigned char operation = data[cursor++];
+
+			if (operation == DELTA_COPY)
+			{
+				assert_delta_has(cursor, 12, delta_size);
+				unsigned long long offset = read_integer(data + cursor, 8, Endianness::BIG);
+				size_t length = read_integer(data + cursor + 8, 4, Endianness::BIG);
+				cursor += 12;
+
+				if (offset > base.size() || base.size() - offset < length || target_size - written < length)
+					throw std::runtime_error("Malformed delta: copy operation out of bounds");
+
+				output.insert(output.end(), base.data() + offset, base.data() + offset + length);
+				written += length;
+			}
+			else if (operation == DELTA_LITERAL)
+			{
+				assert_delta_has(cursor, 4, delta_size);
+				size_t length = read_integer(data + cursor, 4, Endianness::BIG);
+				cursor += 4;
+
+				assert_delta_has(cursor, length, delta_size);
+				if (target_size - written < length)
+					throw std::runtime_error("Malformed delta: literal operation out of bounds");
+
+				output.insert(output.end(), data + cursor, data + cursor + length);
+				cursor += length;
+				written += length;
+			}
+			else
+			{
+				throw std::runtime_error("Malformed delta: unknown operation " + std::to_string((int)operation));
+			}
+		}
+
+		if (written != target_size)
+			throw std::runtime_error("Malformed delta: rebuilt " + std::to_string(written) + " byte(s), but expected " + std::to_string(target_size));
+	}
+
+	std::vector<unsigned char> apply_delta(const std::vector<unsigned char> &base, const std::vector<unsigned char> &delta)
+	{
+		std::vector<unsigned char> output;
+
+		apply_delta(base, delta, output);
+
+		return output;
+	}
+}
@@ -17,10 +17,11 @@ namespace bufsd
 
 	std::vector<unsigned char> Deserializer::get_buffer(size_t size)
 	{
-		this->assert_is_available(size);
+		if (!this->check_available(size))
+			return {};
 
-		std::vector<unsigned char>::iterator begin = this->buffer.begin() + this->cursor;
-		std::vector<unsigned char>::iterator end = begin + size;
+		const unsigned char *begin = this->data + this->cursor;
+		const unsigned char *end = begin + size;
 
 		this->cursor += size;
 		this->update_remaining();
@@ -28,6 +29,43 @@ namespace bufsd
 		return std::vector<unsigned char>(begin, end);
 	}
 
+	void Deserializer::get_buffer(size_t size, std::vector<unsigned char> &destination)
+	{
+		if (!this->check_available(size))
+			return destination.clear();
+
+		const unsigned char *begin = this->data + this->cursor;
+		destination.assign(begin, begin + size);
+
+		this->cursor += size;
+		this->update_remaining();
+	}
+
+	void Deserializer::get_string(size_t size, std::string &destination)
+	{
+		if (!this->check_available(size))
+			return destination.clear();
+
+		destination.assign((const char *)(this->data + this->cursor), size);
+
+		this->cursor += size;
+		this->update_remaining();
+	}
+
+	Deserializer Deserializer::get_view(size_t size)
+	{
+		if (!this->check_available(size))
+			size = 0;
+
+		Deserializer view(this->data + this->cursor, size);
+		view.throwing = this->throwing;
+
+		this->cursor += size;
+		this->update_remaining();
+
+		return view;
+	}
+
 	unsigned short Deserializer::get_16_big_endian()
 	{
 		return (unsigned short)this->get_big_endian(2);
@@ -45,12 +83,13 @@ namespace bufsd
 
 	unsigned long long Deserializer::get_big_endian(size_t amount_of_bytes)
 	{
-		assert_is_available(amount_of_bytes);
+		if (!this->check_available(amount_of_bytes))
+			return 0;
 
 		unsigned long long value = 0;
 
 		for (int i = (int)amount_of_bytes - 1; i >= 0; i--)
-			value |= (unsigned long long)this->buffer[this->cursor++] << 8 * i;
+			value |= (unsigned long long)this->data[this->cursor++] << 8 * i;
 
 		this->update_remaining();
 
@@ -74,27 +113,147 @@ namespace bufsd
 
 	unsigned long long Deserializer::get_little_endian(size_t amount_of_bytes)
 	{
-		assert_is_available(amount_of_bytes);
+		if (!this->check_available(amount_of_bytes))
+			return 0;
 
 		unsigned long long value = 0;
 
 		for (int i = 0; i < amount_of_bytes; i++)
-			value |= (unsigned long long)this->buffer[this->cursor++] << 8 * i;
+			value |= (unsigned long long)this->data[this->cursor++] << 8 * i;
 
 		this->update_remaining();
 
 		return value;
 	}
 
+	std::vector<unsigned char> Deserializer::get_key_buffer(Key_Order order)
+	{
+		const unsigned char flip = order == Key_Order::DESCENDING ? 0xff : 0x00;
+		std::vector<unsigned char> values;
+		size_t position = this->cursor;
+
+		while (true)
+		{
+			if (this->buffer_size - position < 2)
+			{
+				this->fail("Key field is not terminated before the end of the buffer");
+				return {};
+			}
+
+			unsigned char byte = this->data[position] ^ flip;
+
+			if (byte != 0x00)
+			{
+				values.push_back(byte);
+				position++;
+				continue;
+			}
+
+			unsigned char escape = this->data[position + 1] ^ flip;
+			position += 2;
+
+			if (escape == 0x01)
+				break;
+			if (escape != 0xff)
+			{
+				this->fail("Invalid escape sequence in key field");
+				return {};
+			}
+
+			values.push_back(0x00);
+		}
+
+		this->cursor = position;
+		this->update_remaining();
+
+		return values;
+	}
+
+	std::string Deserializer::get_key_string(Key_Order order)
+	{
+		std::vector<unsigned char> values = this->get_key_buffer(order);
+
+		return std::string(values.begin(), values.end());
+	}
+
 	Deserializer::Deserializer(const std::vector<unsigned char> &buffer)
 		: buffer(buffer), buffer_size(buffer.size()), remaining(buffer.size())
+	{
+		this->data = this->buffer.data();
+	}
+
+	Deserializer::Deserializer(const unsigned char *data, size_t size)
+		: data(data), owns_buffer(false), buffer_size(size), remaining(size)
 	{
 	}
 
-	void Deserializer::assert_is_available(size_t amount_of_bytes) const
+	Deserializer::Deserializer(const Deserializer &other)
+		: buffer(other.buffer), data(other.data), owns_buffer(other.owns_buffer), cursor(other.cursor), buffer_size(other.buffer_size), remaining(other.remaining), throwing(other.throwing), failed(other.failed)
 	{
-		if (this->remaining < amount_of_bytes)
-			throw std::runtime_error(make_error_message(amount_of_bytes, this->remaining));
+		if (this->owns_buffer)
+			this->data = this->buffer.data();
+	}
+
+	Deserializer &Deserializer::operator=(const Deserializer &other)
+	{
+		if (this == &other)
+			return *this;
+
+		this->buffer = other.buffer;
+		this->data = other.owns_buffer ? this->buffer.data() : other.data;
+		this->owns_buffer = other.owns_buffer;
+		this->cursor = other.cursor;
+		this->buffer_size = other.buffer_size;
+		this->remaining = other.remaining;
+		this->throwing = other.throwing;
+		this->failed = other.failed;
+
+		return *this;
+	}
+
+	bool Deserializer::check_available(size_t amount_of_bytes) const
+	{
+		if (this->remaining >= amount_of_bytes)
+			return true;
+
+		this->fail(make_error_message(amount_of_bytes, this->remaining));
+
+		return false;
+	}
+
+	void Deserializer::fail(const std::string &message) const
+	{
+		if (this->throwing)
+			throw std::runtime_error(message);
+
+		this->failed = true;
+	}
+
+	Deserializer::Checkpoint Deserializer::checkpoint() const
+	{
+		return {this->cursor, this->failed};
+	}
+
+	void Deserializer::restore(const Checkpoint &checkpoint)
+	{
+		this->cursor = checkpoint.cursor;
+		this->failed = checkpoint.failed;
+		this->update_remaining();
+	}
+
+	void Deserializer::set_throwing(bool throwing)
+	{
+		this->throwing = throwing;
+	}
+
+	bool Deserializer::is_throwing() const
+	{
+		return this->throwing;
+	}
+
+	bool Deserializer::has_failed() const
+	{
+		return this->failed;
 	}
 
 	void Deserializer::update_remaining()
@@ -120,9 +279,64 @@ namespace bufsd
 		return this->buffer_size;
 	}
 
+	unsigned char Deserializer::peek_byte(size_t offset) const
+	{
+		return (unsigned char)this->peek_integer(offset, 1, Endianness::BIG);
+	}
+
+	unsigned short Deserializer::peek_16_big_endian(size_t offset) const
+	{
+		return (unsigned short)this->peek_integer(offset, 2, Endianness::BIG);
+	}
+
+	unsigned int Deserializer::peek_32_big_endian(size_t offset) const
+	{
+		return (unsigned int)this->peek_integer(offset, 4, Endianness::BIG);
+	}
+
+	unsigned long long Deserializer::peek_64_big_endian(size_t offset) const
+	{
+		return this->peek_integer(offset, 8, Endianness::BIG);
+	}
+
+	unsigned short Deserializer::peek_16_little_endian(size_t offset) const
+	{
+		return (unsigned short)this->peek_integer(offset, 2, Endianness::LITTLE);
+	}
+
+	unsigned int Deserializer::peek_32_little_endian(size_t offset) const
+	{
+		return (unsigned int)this->peek_integer(offset, 4, Endianness::LITTLE);
+	}
+
+	unsigned long long Deserializer::peek_64_little_endian(size_t offset) const
+	{
+		return this->peek_integer(offset, 8, Endianness::LITTLE);
+	}
+
+	unsigned long long Deserializer::peek_integer(size_t offset, size_t amount_of_bytes, Endianness endianness) const
+	{
+		if (offset > this->remaining)
+		{
+			this->fail(make_error_message(offset + amount_of_bytes, this->remaining));
+			return 0;
+		}
+
+		if (!this->check_available(offset + amount_of_bytes))
+			return 0;
+
+		return read_integer(this->data + this->cursor + offset, amount_of_bytes, endianness);
+	}
+
+	const unsigned char *Deserializer::get_data() const
+	{
+		return this->data;
+	}
+
 	void Deserializer::skip(size_t amount_of_bytes)
 	{
-		this->assert_is_available(amount_of_bytes);
+		if (!this->check_available(amount_of_bytes))
+			return;
 
 		this->cursor += amount_of_bytes;
 		this->update_remaining();
@@ -136,24 +350,31 @@ namespace bufsd
 
 	void Deserializer::set_cursor(size_t position)
 	{
-		this->reset_cursor();
-		this->skip(position);
+		// Checked before moving, so a failed call in non-throwing mode leaves the cursor where it was
+		if (position > this->buffer_size)
+		{
+			this->fail("Cannot move the cursor to position " + std::to_string(position) + " of a " + std::to_string(this->buffer_size) + " byte(s) buffer");
+			return;
+		}
+
+		this->cursor = position;
+		this->update_remaining();
 	}
 
 	void Deserializer::print_buffer(char sep)
 	{
-		printf("Buffer with %zd bytes long:\n", this->buffer.size());
-		for (int i = 0; i < this->buffer.size(); i++)
+		printf("Buffer with %zd bytes long:\n", this->buffer_size);
+		for (int i = 0; i < this->buffer_size; i++)
 		{
 			if (i)
 				printf("%c", sep);
-			printf("%02x", this->buffer[i]);
+			printf("%02x", this->data[i]);
 		}
 		printf("\n");
 	}
 
 	std::string Deserializer::get_buffer_string()
 	{
-		return bufsd::make_buffer_string(this->buffer);
+		return bufsd::make_buffer_string(std::vector<unsigned char>(this->data, this->data + this->buffer_size));
 	}
 }
\ No newline at end of file
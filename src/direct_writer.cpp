@@ -0,0 +1,329 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bufsd/direct_writer.h"
+
+namespace bufsd
+{
+	static std::string make_system_error_message(const std::string &action, const std::string &path)
+	{
+		return "Could not " + action + " " + path + ": " + std::strerror(errno);
+	}
+
+	Direct_Writer::Direct_Writer(const std::string &path, const Direct_Writer_Options &options)
+		: path(path), sync(options.sync)
+	{
+		this->alignment = 512;
+		while (this->alignment < options.alignment)
+			this->alignment <<= 1;
+
+		this->buffer_size = std::max(options.buffer_size, this->alignment);
+		this->buffer_size = (this->buffer_size + this->alignment - 1) / this->alignment * this->alignment;
+
+		const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+
+#ifdef O_DIRECT
+		if (options.direct)
+		{
+			this->fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+
+			// tmpfs and some network file systems refuse O_DIRECT
+			if (this->fd >= 0)
+				this->direct = true;
+			else if (errno != EINVAL)
+				throw std::runtime_error(make_system_error_message("open", path));
+		}
+#endif
+
+		if (this->fd < 0)
+		{
+			this->fd = ::open(path.c_str(), flags, 0644);
+			if (this->fd < 0)
+				throw std::runtime_error(make_system_error_message("open", path));
+
+#ifdef F_NOCACHE
+			if (options.direct && ::fcntl(this->fd, F_NOCACHE, 1) == 0)
+				this->direct = true;
+#endif
+		}
+
+		for (unsigned char *&buffer : this->buffers)
+		{
+			void *memory = nullptr;
+
+			if (::posix_memalign(&memory, this->alignment, this->buffer_size) != 0)
+			{
+				std::free(this->buffers[0]);
+				::close(this->fd);
+				throw std::runtime_error("Could not allocate " + std::to_string(this->buffer_size) + " bytes aligned to " + std::to_string(this->alignment));
+			}
+
+			buffer = static_cast<unsigned char *>(memory);
+		}
+
+		this->writer = std::thread(&Direct_Writer::run_writer, this);
+	}
+
+	Direct_Writer::~Direct_Writer()
+	{
+		try
+		{
+			this->close();
+		}
+		catch (const std::runtime_error &)
+		{
+		}
+
+		std::free(this->buffers[0]);
+		std::free(this->buffers[1]);
+	}
+
+	Direct_Writer &Direct_Writer::write(const unsigned char *data, size_t size)
+	{
+		this->assert_open();
+
+		while (size > 0)
+		{
+			size_t amount = std::min(size, this->buffer_size - this->fill);
+
+			std::memcpy(this->buffers[this->current] + this->fill, data, amount);
+			this->fill += amount;
+			data += amount;
+			size -= amount;
+
+			if (this->fill == this->buffer_size)
+				this->hand_over();
+		}
+
+		return *this;
+	}
+
+	Direct_Writer &Direct_Writer::write(Serializer &serializer)
+	{
+		const std::vector<unsigned char> &buffer = serializer.get_buffer();
+
+		return this->write(buffer.data(), buffer.size());
+	}
+
+	Direct_Writer &Direct_Writer::write_frame(Serializer &serializer, const Length_Prefix &prefix)
+	{
+		const std::vector<unsigned char> &buffer = serializer.get_buffer();
+
+		unsigned char size[8];
+		prefix.write(size, buffer.size());
+
+		this->write(size, prefix.number_of_bytes);
+
+		return this->write(buffer.data(), buffer.size());
+	}
+
+	unsigned long long Direct_Writer::write_placeholder(size_t amount_of_bytes)
+	{
+		static const unsigned char zeros[256] = {};
+
+		unsigned long long offset = this->get_size();
+
+		while (amount_of_bytes > 0)
+		{
+			size_t amount = std::min(amount_of_bytes, sizeof(zeros));
+			this->write(zeros, amount);
+			amount_of_bytes -= amount;
+		}
+
+		return offset;
+	}
+
+	Direct_Writer &Direct_Writer::patch(unsigned long long offset, const unsigned char *data, size_t size)
+	{
+		this->assert_open();
+
+		if (offset + size > this->get_size())
+			throw std::runtime_error("Tried to patch " + std::to_string(size) + " bytes at offset " + std::to_string(offset) + ", but only " + std::to_string(this->get_size()) + " bytes were written");
+
+		if (offset >= this->buffer_offset)
+			std::memcpy(this->buffers[this->current] + (offset - this->buffer_offset), data, size);
+		else
+			this->patches.push_back({offset, std::vector<unsigned char>(data, data + size)});
+
+		return *this;
+	}
+
+	void Direct_Writer::close()
+	{
+		if (this->fd < 0)
+			return;
+
+		std::string failure;
+
+		try
+		{
+			this->wait_idle();
+		}
+		catch (const std::runtime_error &exception)
+		{
+			failure = exception.what();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+
+		this->wake_writer.notify_one();
+		this->writer.join();
+
+		const unsigned long long size = this->get_size();
+
+		// O_DIRECT only writes whole aligned blocks, so the tail is padded and the padding trimmed afterwards
+		if (failure.empty() && this->fill > 0)
+		{
+			size_t padded = this->direct ? (this->fill + this->alignment - 1) / this->alignment * this->alignment : this->fill;
+			std::memset(this->buffers[this->current] + this->fill, 0, padded - this->fill);
+
+			if (this->write_at(this->buffers[this->current], padded, this->buffer_offset, failure) && padded != this->fill && ::ftruncate(this->fd, (off_t)size) != 0)
+				failure = make_system_error_message("truncate", this->path);
+		}
+
+		if (failure.empty() && !this->patches.empty())
+		{
+#ifdef O_DIRECT
+			if (this->direct)
+				::fcntl(this->fd, F_SETFL, ::fcntl(this->fd, F_GETFL) & ~O_DIRECT);
+#endif
+
+			for (const Pending_Patch &pending : this->patches)
+			{
+				if (!this->write_at(pending.bytes.data(), pending.bytes.size(), pending.offset, failure))
+					break;
+			}
+		}
+
+		if (failure.empty() && this->sync && ::fdatasync(this->fd) != 0)
+			failure = make_system_error_message("sync", this->path);
+
+		::close(this->fd);
+		this->fd = -1;
+		this->patches.clear();
+
+		if (!failure.empty())
+			throw std::runtime_error(failure);
+	}
+
+	unsigned long long Direct_Writer::get_size() const
+	{
+		return this->buffer_offset + this->fill;
+	}
+
+	bool Direct_Writer::is_direct() const
+	{
+		return this->direct;
+	}
+
+	void Direct_Writer::hand_over()
+	{
+		this->wait_idle();
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->has_queued = true;
+			this->queued_buffer = this->current;
+			this->queued_size = this->fill;
+			this->queued_offset = this->buffer_offset;
+		}
+
+		this->wake_writer.notify_one();
+
+		// The other buffer was handed over before the one just queued, so wait_idle() already saw it written
+		this->current ^= 1;
+		this->buffer_offset += this->fill;
+		this->fill = 0;
+	}
+
+	void Direct_Writer::wait_idle()
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->buffer_written.wait(lock, [this]
+								  { return !this->has_queued; });
+
+		if (!this->error.empty())
+			throw std::runtime_error(this->error);
+	}
+
+	void Direct_Writer::run_writer()
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+
+		while (true)
+		{
+			this->wake_writer.wait(lock, [this]
+								   { return this->has_queued || this->stopping; });
+
+			if (!this->has_queued)
+				return;
+
+			const unsigned char *data = this->buffers[this->queued_buffer];
+			size_t size = this->queued_size;
+			unsigned long long offset = this->queued_offset;
+
+			lock.unlock();
+			std::string failure;
+			this->write_at(data, size, offset, failure);
+			lock.lock();
+
+			if (!failure.empty() && this->error.empty())
+				this->error = failure;
+
+			this->has_queued = false;
+			this->buffer_written.notify_all();
+		}
+	}
+
+	bool Direct_Writer::write_at(const unsigned char *data, size_t size, unsigned long long offset, std::string &failure)
+	{
+		while (size > 0)
+		{
+			ssize_t written = ::pwrite(this->fd, data, size, (off_t)offset);
+
+			if (written < 0 && errno == EINTR)
+				continue;
+
+#ifdef O_DIRECT
+			// Some file systems accept O_DIRECT at open time but reject the writes
+			if (written < 0 && errno == EINVAL && this->direct)
+			{
+				::fcntl(this->fd, F_SETFL, ::fcntl(this->fd, F_GETFL) & ~O_DIRECT);
+				this->direct = false;
+				continue;
+			}
+#endif
+
+			if (written <= 0)
+			{
+				failure = make_system_error_message("write", this->path);
+				return false;
+			}
+
+			data += written;
+			size -= (size_t)written;
+			offset += (unsigned long long)written;
+		}
+
+		return true;
+	}
+
+	void Direct_Writer::assert_open() const
+	{
+		if (this->fd < 0)
+			throw std::runtime_error("Direct writer for " + this->path + " is closed");
+	}
+}
+
+#endif
@@ -0,0 +1,317 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#include "bufsd/frame_forwarder.h"
+
+namespace bufsd
+{
+	static const size_t MAX_TRANSFER = 1 << 30;
+
+	static std::string make_system_error_message(const std::string &action, const std::string &path)
+	{
+		return "Could not " + action + " " + path + ": " + std::strerror(errno);
+	}
+
+	// Blocks until a non-blocking destination accepts more bytes
+	static void wait_writable(int destination)
+	{
+		struct pollfd descriptor;
+		descriptor.fd = destination;
+		descriptor.events = POLLOUT;
+		descriptor.revents = 0;
+
+		while (::poll(&descriptor, 1, -1) < 0 && errno == EINTR)
+		{
+		}
+	}
+
+	Frame_Forwarder::Frame_Forwarder(const std::string &path, const Length_Prefix &prefix)
+		: path(path), prefix(prefix)
+	{
+		this->prefix.validate();
+
+		this->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (this->fd < 0)
+			throw std::runtime_error(make_system_error_message("open", path));
+	}
+
+	Frame_Forwarder::~Frame_Forwarder()
+	{
+		if (this->pipe_fds[0] >= 0)
+		{
+			::close(this->pipe_fds[0]);
+			::close(this->pipe_fds[1]);
+		}
+
+		::close(this->fd);
+	}
+
+	size_t Frame_Forwarder::forward(int destination, size_t max_frames, unsigned long long max_bytes)
+	{
+		const size_t prefix_size = this->prefix.number_of_bytes;
+		const unsigned long long file_size = this->get_file_size();
+
+		unsigned long long end = this->position;
+		size_t frames = 0;
+
+		// Stored frames are contiguous, so any run of them is a single extent for the kernel to move
+		while (frames < max_frames && end <= file_size && file_size - end >= prefix_size)
+		{
+			unsigned char prefix_bytes[8];
+			ssize_t result = ::pread(this->fd, prefix_bytes, prefix_size, (off_t)end);
+
+			if (result < 0 && errno == EINTR)
+				continue;
+
+			if (result < 0)
+				throw std::runtime_error(make_system_error_message("read a length prefix of", this->path));
+
+			if ((size_t)result < prefix_size)
+				break;
+
+			size_t payload_size = this->prefix.read(prefix_bytes);
+
+			// A frame still being appended, or a forged length that would wrap around when added to end
+			if (!this->prefix.fits(payload_size, file_size - end))
+				break;
+
+			unsigned long long frame_end = end + prefix_size + payload_size;
+
+			if (frames > 0 && frame_end - this->position > max_bytes)
+				break;
+
+			end = frame_end;
+			frames++;
+		}
+
+		if (frames > 0)
+			this->transfer(destination, end - this->position);
+
+		return frames;
+	}
+
+	unsigned long long Frame_Forwarder::forward(int destination, const Frame_Index &index, size_t first_frame, size_t frame_count)
+	{
+		if (frame_count == 0)
+			return 0;
+
+		unsigned long long start = index.get_offset(first_frame);
+		unsigned long long end = index.get_offset(first_frame + frame_count - 1) + index.get_frame_size(first_frame + frame_count - 1);
+
+		this->position = start;
+		this->transfer(destination, end - start);
+
+		return end - start;
+	}
+
+	void Frame_Forwarder::seek(unsigned long long offset)
+	{
+		this->position = offset;
+	}
+
+	unsigned long long Frame_Forwarder::get_position() const
+	{
+		return this->position;
+	}
+
+	unsigned long long Frame_Forwarder::get_file_size() const
+	{
+		struct stat status;
+
+		if (::fstat(this->fd, &status) != 0)
+			throw std::runtime_error(make_system_error_message("stat", this->path));
+
+		return (unsigned long long)status.st_size;
+	}
+
+	void Frame_Forwarder::transfer(int destination, unsigned long long size)
+	{
+#ifdef __linux__
+		while (size > 0)
+		{
+			off_t file_offset = (off_t)this->position;
+			ssize_t sent = ::sendfile(destination, this->fd, &file_offset, (size_t)std::min<unsigned long long>(size, MAX_TRANSFER));
+
+			if (sent < 0 && errno == EINTR)
+				continue;
+
+			if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				wait_writable(destination);
+				continue;
+			}
+
+			// sendfile refuses some destination types, splice through a pipe may still avoid the copy
+			if (sent < 0 && (errno == EINVAL || errno == ENOSYS))
+				return this->splice_transfer(destination, size);
+
+			if (sent < 0)
+				throw std::runtime_error(make_system_error_message("forward frames of", this->path));
+
+			if (sent == 0)
+				throw std::runtime_error("Could not forward frames of " + this->path + ": the file got shorter");
+
+			this->position += (unsigned long long)sent;
+			size -= (unsigned long long)sent;
+		}
+#else
+		this->copy_transfer(destination, size);
+#endif
+	}
+
+	void Frame_Forwarder::splice_transfer(int destination, unsigned long long size)
+	{
+#ifdef __linux__
+		if (this->pipe_fds[0] < 0 && ::pipe2(this->pipe_fds, O_CLOEXEC) != 0)
+			throw std::runtime_error(make_system_error_message("create a pipe to forward", this->path));
+
+		try
+		{
+			this->splice_through_pipe(destination, this->position, size);
+		}
+		catch (...)
+		{
+			// Bytes stuck in the pipe would be sent ahead of the next transfer, so the pipe is dropped with them
+			::close(this->pipe_fds[0]);
+			::close(this->pipe_fds[1]);
+			this->pipe_fds[0] = this->pipe_fds[1] = -1;
+			throw;
+		}
+#else
+		this->copy_transfer(destination, size);
+#endif
+	}
+
+	void Frame_Forwarder::splice_through_pipe(int destination, unsigned long long offset, unsigned long long size)
+	{
+#ifdef __linux__
+		// offset reads ahead of the position, which only counts the bytes that left the pipe
+		while (size > 0)
+		{
+			loff_t file_offset = (loff_t)offset;
+			ssize_t in_pipe = ::splice(this->fd, &file_offset, this->pipe_fds[1], nullptr, (size_t)std::min<unsigned long long>(size, MAX_TRANSFER), SPLICE_F_MOVE | SPLICE_F_MORE);
+
+			if (in_pipe < 0 && errno == EINTR)
+				continue;
+
+			if (in_pipe < 0 && (errno == EINVAL || errno == ENOSYS))
+				return this->copy_transfer(destination, size);
+
+			if (in_pipe < 0)
+				throw std::runtime_error(make_system_error_message("forward frames of", this->path));
+
+			if (in_pipe == 0)
+				throw std::runtime_error("Could not forward frames of " + this->path + ": the file got shorter");
+
+			offset += (unsigned long long)in_pipe;
+			size -= (unsigned long long)in_pipe;
+
+			while (in_pipe > 0)
+			{
+				ssize_t out = ::splice(this->pipe_fds[0], nullptr, destination, nullptr, (size_t)in_pipe, SPLICE_F_MOVE | (size > 0 ? SPLICE_F_MORE : 0));
+
+				if (out < 0 && errno == EINTR)
+					continue;
+
+				if (out < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				{
+					wait_writable(destination);
+					continue;
+				}
+
+				// Destinations opened with O_APPEND refuse splice too, so the bytes already in the pipe are copied
+				if (out < 0 && errno == EINVAL)
+				{
+					unsigned char buffer[64 * 1024];
+
+					while (in_pipe > 0)
+					{
+						ssize_t read = ::read(this->pipe_fds[0], buffer, (size_t)std::min<ssize_t>(in_pipe, sizeof(buffer)));
+
+						if (read < 0 && errno == EINTR)
+							continue;
+
+						if (read <= 0)
+							throw std::runtime_error(make_system_error_message("forward frames of", this->path));
+
+						this->write_all(destination, buffer, (size_t)read);
+						in_pipe -= read;
+					}
+
+					return this->copy_transfer(destination, size);
+				}
+
+				if (out <= 0)
+					throw std::runtime_error(make_system_error_message("forward frames of", this->path));
+
+				this->position += (unsigned long long)out;
+				in_pipe -= out;
+			}
+		}
+#else
+		this->copy_transfer(destination, size);
+#endif
+	}
+
+	void Frame_Forwarder::copy_transfer(int destination, unsigned long long size)
+	{
+		unsigned char buffer[64 * 1024];
+
+		while (size > 0)
+		{
+			ssize_t read = ::pread(this->fd, buffer, (size_t)std::min<unsigned long long>(size, sizeof(buffer)), (off_t)this->position);
+
+			if (read < 0 && errno == EINTR)
+				continue;
+
+			if (read < 0)
+				throw std::runtime_error(make_system_error_message("read", this->path));
+
+			if (read == 0)
+				throw std::runtime_error("Could not forward frames of " + this->path + ": the file got shorter");
+
+			this->write_all(destination, buffer, (size_t)read);
+
+			size -= (unsigned long long)read;
+		}
+	}
+
+	void Frame_Forwarder::write_all(int destination, const unsigned char *data, size_t size)
+	{
+		while (size > 0)
+		{
+			ssize_t written = ::write(destination, data, size);
+
+			if (written < 0 && errno == EINTR)
+				continue;
+
+			if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				wait_writable(destination);
+				continue;
+			}
+
+			if (written <= 0)
+				throw std::runtime_error(make_system_error_message("forward frames of", this->path));
+
+			this->position += (unsigned long long)written;
+			data += written;
+			size -= (size_t)written;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,233 @@
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+
+#include "bufsd/frame_index.h"
+#include "bufsd/serializer.h"
+#include "bufsd/deserializer.h"
+
+namespace bufsd
+{
+	static const unsigned long long FRAME_INDEX_MAGIC = 0x4255465344464931; // "BUFSDFI1"
+	static const size_t SCAN_CHUNK_SIZE = 1024 * 1024;
+
+	Frame_Index Frame_Index::build(const std::string &stream_path, const Length_Prefix &prefix)
+	{
+		prefix.validate();
+
+		std::ifstream file(stream_path, std::ios::binary | std::ios::ate);
+		if (!file)
+			throw std::runtime_error("Could not open framed stream " + stream_path);
+
+		const unsigned long long stream_size = (unsigned long long)file.tellg();
+		const size_t prefix_size = prefix.number_of_bytes;
+
+		Frame_Index index;
+		index.prefix = prefix;
+
+		std::vector<unsigned char> chunk(SCAN_CHUNK_SIZE);
+		unsigned long long chunk_offset = 0;
+		size_t chunk_size = 0;
+		unsigned long long offset = 0;
+		unsigned long long frame_size = 0;
+
+		while (stream_size - offset >= prefix_size)
+		{
+			if (offset < chunk_offset || offset + prefix_size > chunk_offset + chunk_size)
+			{
+				// After a frame larger than a chunk, the next one is likely large too, so only its prefix is read
+				size_t read_size = frame_size > SCAN_CHUNK_SIZE ? prefix_size : chunk.size();
+
+				file.clear();
+				file.seekg((std::streamoff)offset);
+				file.read(reinterpret_cast<char *>(chunk.data()), read_size);
+
+				chunk_offset = offset;
+				chunk_size = (size_t)file.gcount();
+
+				if (chunk_size < prefix_size)
+					throw std::runtime_error("Could not read framed stream " + stream_path);
+			}
+
+			size_t payload_size = prefix.read(chunk.data() + (offset - chunk_offset));
+			if (!prefix.fits(payload_size, stream_size - offset))
+				break;
+
+			frame_size = prefix_size + payload_size;
+			offset += frame_size;
+			index.offsets.push_back(offset);
+		}
+
+		return index;
+	}
+
+	Frame_Index Frame_Index::build(const unsigned char *data, size_t size, const Length_Prefix &prefix)
+	{
+		prefix.validate();
+
+		const size_t prefix_size = prefix.number_of_bytes;
+
+		Frame_Index index;
+		index.prefix = prefix;
+
+		size_t offset = 0;
+
+		while (size - offset >= prefix_size)
+		{
+			size_t payload_size = prefix.read(data + offset);
+			if (!prefix.fits(payload_size, size - offset))
+				break;
+
+			offset += prefix_size + payload_size;
+			index.offsets.push_back(offset);
+		}
+
+		return index;
+	}
+
+	Frame_Index Frame_Index::load(const std::string &index_path)
+	{
+		std::ifstream file(index_path, std::ios::binary);
+		if (!file)
+			throw std::runtime_error("Could not open frame index " + index_path);
+
+		std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		if (bytes.size() < 4)
+			throw std::runtime_error("Frame index " + index_path + " is too small to be valid");
+
+		size_t body_size = bytes.size() - 4;
+		if (crc32c(bytes.data(), body_size) != (unsigned int)read_integer(bytes.data() + body_size, 4, Endianness::BIG))
+			throw std::runtime_error("Frame index " + index_path + " is corrupted");
+
+		Deserializer deserializer(bytes.data(), body_size);
+
+		if (deserializer.get_64_big_endian() != FRAME_INDEX_MAGIC)
+			throw std::runtime_error(index_path + " is not a frame index");
+
+		Frame_Index index;
+		index.prefix.number_of_bytes = deserializer.get_byte();
+		if (index.prefix.number_of_bytes < 1 || index.prefix.number_of_bytes > 8)
+			throw std::runtime_error("Frame index " + index_path + " is corrupted");
+
+		index.prefix.endianness = deserializer.get_byte() ? Endianness::LITTLE : Endianness::BIG;
+
+		unsigned long long frame_count = deserializer.get_64_big_endian();
+		if (frame_count > deserializer.get_remaining())
+			throw std::runtime_error("Frame index " + index_path + " is corrupted");
+
+		index.offsets.reserve((size_t)frame_count + 1);
+
+		unsigned long long offset = 0;
+		for (unsigned long long frame = 0; frame < frame_count; frame++)
+		{
+			unsigned long long delta = 0;
+			unsigned int shift = 0;
+			unsigned char byte;
+
+			do
+			{
+				byte = deserializer.get_byte();
+				delta |= (unsigned long long)(byte & 0x7f) << shift;
+				shift += 7;
+			} while ((byte & 0x80) && shift < 64);
+
+			offset += delta;
+			index.offsets.push_back(offset);
+		}
+
+		return index;
+	}
+
+	void Frame_Index::save(const std::string &index_path) const
+	{
+		Serializer serializer;
+		serializer.push_64_big_endian(FRAME_INDEX_MAGIC)
+			.push_byte(this->prefix.number_of_bytes)
+			.push_byte((unsigned char)(this->prefix.endianness == Endianness::LITTLE ? 1 : 0))
+			.push_64_big_endian((unsigned long long)this->get_frame_count());
+
+		for (size_t frame = 0; frame < this->get_frame_count(); frame++)
+		{
+			unsigned long long delta = this->offsets[frame + 1] - this->offsets[frame];
+
+			while (delta >= 0x80)
+			{
+				serializer.push_byte((unsigned char)((delta & 0x7f) | 0x80));
+				delta >>= 7;
+			}
+			serializer.push_byte((unsigned char)delta);
+		}
+
+		const std::vector<unsigned char> &body = serializer.get_buffer();
+		unsigned char checksum[4];
+		write_integer(checksum, crc32c(body.data(), body.size()), 4, Endianness::BIG);
+
+		std::ofstream file(index_path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char *>(body.data()), body.size());
+		file.write(reinterpret_cast<const char *>(checksum), sizeof(checksum));
+
+		if (!file.flush())
+			throw std::runtime_error("Could not write frame index " + index_path);
+	}
+
+	size_t Frame_Index::get_frame_count() const
+	{
+		return this->offsets.size() - 1;
+	}
+
+	unsigned long long Frame_Index::get_offset(size_t frame) const
+	{
+		this->assert_frame_exists(frame);
+
+		return this->offsets[frame];
+	}
+
+	unsigned long long Frame_Index::get_frame_size(size_t frame) const
+	{
+		this->assert_frame_exists(frame);
+
+		return this->offsets[frame + 1] - this->offsets[frame];
+	}
+
+	unsigned long long Frame_Index::get_indexed_size() const
+	{
+		return this->offsets.back();
+	}
+
+	const Length_Prefix &Frame_Index::get_prefix() const
+	{
+		return this->prefix;
+	}
+
+	std::vector<Frame_Shard> Frame_Index::split(size_t amount_of_shards) const
+	{
+		std::vector<Frame_Shard> shards;
+		size_t frame_count = this->get_frame_count();
+
+		if (amount_of_shards == 0 || frame_count == 0)
+			return shards;
+
+		size_t base = frame_count / amount_of_shards;
+		size_t extra = frame_count % amount_of_shards;
+		size_t first = 0;
+
+		for (size_t shard = 0; shard < amount_of_shards && first < frame_count; shard++)
+		{
+			size_t count = base + (shard < extra ? 1 : 0);
+			if (count == 0)
+				break;
+
+			shards.push_back({first, count, this->offsets[first], this->offsets[first + count] - this->offsets[first]});
+			first += count;
+		}
+
+		return shards;
+	}
+
+	void Frame_Index::assert_frame_exists(size_t frame) const
+	{
+		if (frame >= this->get_frame_count())
+			throw std::runtime_error("Frame " + std::to_string(frame) + " doesn't exist, the index has " + std::to_string(this->get_frame_count()) + " frame(s)");
+	}
+}
@@ -0,0 +1,81 @@
+#include <stdexcept>
+
+#include "bufsd/graph_serializer.h"
+
+namespace bufsd
+{
+	Graph_Serializer::Graph_Serializer(Serializer &serializer)
+		: serializer(serializer)
+	{
+	}
+
+	Serializer &Graph_Serializer::get_serializer()
+	{
+		return this->serializer;
+	}
+
+	size_t Graph_Serializer::get_object_count() const
+	{
+		return this->ids.size();
+	}
+
+	bool Graph_Serializer::push_reference(const std::shared_ptr<const void> &object, const std::type_info &type)
+	{
+		if (!object)
+		{
+			this->serializer.push_byte((unsigned char)Graph_Tag::NULL_REFERENCE);
+			return false;
+		}
+
+		auto inserted = this->ids.emplace(Object_Key{object.get(), std::type_index(type)}, Written_Object{(unsigned int)this->ids.size(), object});
+
+		if (!inserted.second)
+		{
+			this->serializer.push_byte((unsigned char)Graph_Tag::BACK_REFERENCE).push_32_big_endian(inserted.first->second.id);
+			return false;
+		}
+
+		// New objects don't write their ID: the reader numbers them in the same order
+		this->serializer.push_byte((unsigned char)Graph_Tag::NEW_OBJECT);
+
+		return true;
+	}
+
+	Graph_Deserializer::Graph_Deserializer(Deserializer &deserializer)
+		: deserializer(deserializer)
+	{
+	}
+
+	Deserializer &Graph_Deserializer::get_deserializer()
+	{
+		return this->deserializer;
+	}
+
+	size_t Graph_Deserializer::get_object_count() const
+	{
+		return this->objects.size();
+	}
+
+	Graph_Tag Graph_Deserializer::get_tag()
+	{
+		unsigned char tag = this->deserializer.get_byte();
+
+		if (tag > (unsigned char)Graph_Tag::BACK_REFERENCE)
+			throw std::runtime_error("Invalid graph reference tag " + std::to_string(tag));
+
+		return (Graph_Tag)tag;
+	}
+
+	std::shared_ptr<void> Graph_Deserializer::get_back_reference(const std::type_info &type)
+	{
+		unsigned int id = this->deserializer.get_32_big_endian();
+
+		if (id >= this->objects.size())
+			throw std::runtime_error("Back-reference to object " + std::to_string(id) + ", but only " + std::to_string(this->objects.size()) + " object(s) were read");
+
+		if (*this->objects[id].type != type)
+			throw std::runtime_error("Back-reference to object " + std::to_string(id) + " expects another type than the one it was read as");
+
+		return this->objects[id].object;
+	}
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "bufsd/message_registry.h"
+
+namespace bufsd
+{
+	static const unsigned int MAX_SEED = 1 << 20;
+	static const unsigned int EMPTY_SLOT = 0xffffffff;
+
+	static unsigned long long mix(unsigned long long value)
+	{
+		value ^= value >> 30;
+		value *= 0xbf58476d1ce4e5b9ULL;
+		value ^= value >> 27;
+		value *= 0x94d049bb133111ebULL;
+		value ^= value >> 31;
+
+		return value;
+	}
+
+	static size_t slot_of(unsigned long long hash, unsigned int seed, size_t slot_mask)
+	{
+		return (size_t)(mix(hash + seed * 0x9e3779b97f4a7c15ULL) & slot_mask);
+	}
+
+	Message_Registry::Message_Registry(unsigned char id_size, Endianness endianness, size_t id_offset)
+		: id_size(id_size), endianness(endianness), id_offset(id_offset)
+	{
+		if (id_size < 1 || id_size > 8)
+			throw std::runtime_error("Type IDs must have between 1 and 8 bytes, not " + std::to_string(id_size));
+	}
+
+	Message_Registry &Message_Registry::add(unsigned long long type_id, const Message_Handler &handler)
+	{
+		if (this->id_size < 8 && type_id >> (this->id_size * 8) != 0)
+			throw std::runtime_error("Type ID " + std::to_string(type_id) + " doesn't fit in " + std::to_string(this->id_size) + " byte(s)");
+
+		for (const Entry &entry : this->entries)
+		{
+			if (entry.type_id == type_id)
+				throw std::runtime_error("Type ID " + std::to_string(type_id) + " is already registered");
+		}
+
+		this->entries.push_back({type_id, handler});
+		this->built = false;
+
+		return *this;
+	}
+
+	void Message_Registry::build()
+	{
+		const size_t count = this->entries.size();
+
+		size_t bucket_count = 1;
+		while (bucket_count * 2 < count)
+			bucket_count <<= 1;
+
+		size_t slot_count = 2;
+		while (slot_count < count)
+			slot_count <<= 1;
+
+		// Doubling the table makes a perfect hash easier to find, one attempt at the tightest size is usually enough
+		for (int attempt = 0; attempt < 8; attempt++, slot_count <<= 1)
+		{
+			std::vector<std::vector<unsigned int>> buckets(bucket_count);
+			for (unsigned int i = 0; i < (unsigned int)count; i++)
+				buckets[(size_t)(mix(this->entries[i].type_id) >> 32) & (bucket_count - 1)].push_back(i);
+
+			std::vector<size_t> order(bucket_count);
+			for (size_t i = 0; i < bucket_count; i++)
+				order[i] = i;
+
+			// The largest buckets are placed first, while most slots are still free
+			std::stable_sort(order.begin(), order.end(), [&buckets](size_t first, size_t second)
+							 { return buckets[first].size() > buckets[second].size(); });
+
+			std::vector<unsigned int> seeds(bucket_count, 0);
+			std::vector<unsigned int> slots(slot_count, EMPTY_SLOT);
+			std::vector<size_t> candidate;
+			bool found = true;
+
+			for (size_t bucket : order)
+			{
+				if (buckets[bucket].empty())
+					break;
+
+				unsigned int seed = 0;
+
+				for (; seed < MAX_SEED; seed++)
+				{
+					candidate.clear();
+
+					for (unsigned int entry : buckets[bucket])
+					{
+						size_t slot = slot_of(mix(this->entries[entry].type_id), seed, slot_count - 1);
+
+						if (slots[slot] != EMPTY_SLOT || std::find(candidate.begin(), candidate.end(), slot) != candidate.end())
+							break;
+
+						candidate.push_back(slot);
+					}
+
+					if (candidate.size() == buckets[bucket].size())
+						break;
+				}
+
+				if (seed == MAX_SEED)
+				{
+					found = false;
+					break;
+				}
+
+				seeds[bucket] = seed;
+				for (size_t i = 0; i < candidate.size(); i++)
+					slots[candidate[i]] = buckets[bucket][i];
+			}
+
+			if (found)
+			{
+				this->seeds = std::move(seeds);
+				this->slots = std::move(slots);
+				this->bucket_mask = bucket_count - 1;
+				this->slot_mask = slot_count - 1;
+				this->built = true;
+
+				return;
+			}
+		}
+
+		throw std::runtime_error("Could not build a perfect hash for " + std::to_string(count) + " type IDs");
+	}
+
+	bool Message_Registry::dispatch(Deserializer &frame) const
+	{
+		if (!this->built)
+			throw std::runtime_error("Message registry must be built before dispatching");
+
+		unsigned long long type_id = frame.peek_integer(this->id_offset, this->id_size, this->endianness);
+
+		// A non-throwing frame too short to hold a type ID reads 0, which must not reach the handler of type 0
+		if (frame.get_remaining() < this->id_offset + this->id_size)
+			return false;
+
+		unsigned int entry = this->slots[this->find_slot(type_id)];
+
+		if (entry == EMPTY_SLOT || this->entries[entry].type_id != type_id)
+			return false;
+
+		this->entries[entry].handler(frame);
+
+		return true;
+	}
+
+	bool Message_Registry::contains(unsigned long long type_id) const
+	{
+		if (!this->built)
+			return false;
+
+		unsigned int entry = this->slots[this->find_slot(type_id)];
+
+		return entry != EMPTY_SLOT && this->entries[entry].type_id == type_id;
+	}
+
+	size_t Message_Registry::get_type_count() const
+	{
+		return this->entries.size();
+	}
+
+	size_t Message_Registry::find_slot(unsigned long long type_id) const
+	{
+		unsigned long long hash = mix(type_id);
+
+		return slot_of(hash, this->seeds[(size_t)(hash >> 32) & this->bucket_mask], this->slot_mask);
+	}
+}
@@ -0,0 +1,56 @@
+#include <stdexcept>
+
+#include "bufsd/message_template.h"
+
+namespace bufsd
+{
+	Message_Template::Message_Template(const std::vector<unsigned char> &bytes)
+		: bytes(bytes)
+	{
+	}
+
+	Message_Template::Slot Message_Template::add_slot(const std::string &name, size_t position, size_t number_of_bytes, Endianness endianness)
+	{
+		for (const Patch_Point &point : this->slots)
+		{
+			if (point.name == name)
+				throw std::runtime_error("Patch point " + name + " already exists");
+		}
+
+		if (number_of_bytes == 0 || position > this->bytes.size() || this->bytes.size() - position < number_of_bytes)
+			throw std::runtime_error("Patch point " + name + " of " + std::to_string(number_of_bytes) + " byte(s) at position " + std::to_string(position) + " doesn't fit in a message of " + std::to_string(this->bytes.size()) + " byte(s)");
+
+		this->slots.push_back({name, position, number_of_bytes, endianness});
+
+		return this->slots.size() - 1;
+	}
+
+	Message_Template::Slot Message_Template::find_slot(const std::string &name) const
+	{
+		for (size_t i = 0; i < this->slots.size(); i++)
+		{
+			if (this->slots[i].name == name)
+				return i;
+		}
+
+		throw std::runtime_error("Patch point " + name + " doesn't exist");
+	}
+
+	const Message_Template &Message_Template::patch_buffer(unsigned char *destination, Slot slot, const unsigned char *data, size_t size) const
+	{
+		const Patch_Point &point = this->slots[slot];
+
+		if (size > point.number_of_bytes)
+			throw std::runtime_error("Tried to patch " + std::to_string(size) + " byte(s) into patch point " + point.name + " of " + std::to_string(point.number_of_bytes) + " byte(s)");
+
+		std::memcpy(destination + point.position, data, size);
+		std::memset(destination + point.position + size, 0, point.number_of_bytes - size);
+
+		return *this;
+	}
+
+	const std::vector<unsigned char> &Message_Template::get_bytes() const
+	{
+		return this->bytes;
+	}
+}
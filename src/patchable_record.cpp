@@ -0,0 +1,178 @@
+#include <cstring>
+
+#include "bufsd/patchable_record.h"
+
+namespace bufsd
+{
+	static void assert_valid_width(size_t number_of_bytes)
+	{
+		if (number_of_bytes < 1 || number_of_bytes > 8)
+			throw std::runtime_error("Record field width must be between 1 and 8 bytes, but " + std::to_string(number_of_bytes) + " was given");
+	}
+
+	Record_Layout &Record_Layout::add_fixed(size_t number_of_bytes, Endianness endianness)
+	{
+		assert_valid_width(number_of_bytes);
+
+		this->fields.push_back({false, (unsigned char)number_of_bytes, endianness});
+
+		return *this;
+	}
+
+	Record_Layout &Record_Layout::add_variable(size_t length_prefix_bytes, Endianness endianness)
+	{
+		assert_valid_width(length_prefix_bytes);
+
+		this->fields.push_back({true, (unsigned char)length_prefix_bytes, endianness});
+
+		return *this;
+	}
+
+	size_t Record_Layout::get_field_count() const
+	{
+		return this->fields.size();
+	}
+
+	Patchable_Record::Patchable_Record(const Record_Layout &layout)
+		: layout(layout), values(layout.fields.size()), offsets(layout.fields.size(), 0), dirty(layout.fields.size(), false)
+	{
+		for (size_t i = 0; i < this->layout.fields.size(); i++)
+		{
+			if (!this->layout.fields[i].is_variable)
+				this->values[i].resize(this->layout.fields[i].number_of_bytes, 0);
+		}
+	}
+
+	Patchable_Record &Patchable_Record::set_buffer(size_t field, const unsigned char *data, size_t size)
+	{
+		if (field >= this->layout.fields.size())
+			throw std::runtime_error("Record field " + std::to_string(field) + " doesn't exist");
+
+		if (!this->layout.fields[field].is_variable)
+			throw std::runtime_error("Record field " + std::to_string(field) + " is fixed-width, use set() instead");
+
+		size_t prefix_bytes = this->layout.fields[field].number_of_bytes;
+		if (prefix_bytes < 8 && size >> (prefix_bytes * 8) != 0)
+			throw std::runtime_error("Record field " + std::to_string(field) + " length doesn't fit in its " + std::to_string(prefix_bytes) + " byte(s) length prefix");
+
+		if (size != this->values[field].size())
+			this->full_encode_pending = true;
+
+		return this->store(field, data, size);
+	}
+
+	Patchable_Record &Patchable_Record::set_buffer(size_t field, const std::vector<unsigned char> &values)
+	{
+		return this->set_buffer(field, values.data(), values.size());
+	}
+
+	const std::vector<unsigned char> &Patchable_Record::get_buffer()
+	{
+		if (this->full_encode_pending)
+		{
+			this->encode_all();
+		}
+		else
+		{
+			for (size_t field : this->dirty_fields)
+			{
+				size_t offset = this->offsets[field];
+
+				if (this->layout.fields[field].is_variable)
+					offset += this->layout.fields[field].number_of_bytes;
+
+				if (!this->values[field].empty())
+					std::memcpy(this->buffer.data() + offset, this->values[field].data(), this->values[field].size());
+			}
+		}
+
+		for (size_t field : this->dirty_fields)
+			this->dirty[field] = false;
+		this->dirty_fields.clear();
+
+		return this->buffer;
+	}
+
+	bool Patchable_Record::is_dirty(size_t field) const
+	{
+		return field < this->dirty.size() && this->dirty[field];
+	}
+
+	bool Patchable_Record::needs_full_encode() const
+	{
+		return this->full_encode_pending;
+	}
+
+	size_t Patchable_Record::get_field_offset(size_t field) const
+	{
+		if (field >= this->offsets.size())
+			throw std::runtime_error("Record field " + std::to_string(field) + " doesn't exist");
+
+		return this->offsets[field];
+	}
+
+	Patchable_Record &Patchable_Record::store(size_t field, const unsigned char *data, size_t size)
+	{
+		std::vector<unsigned char> &value = this->values[field];
+
+		if (value.size() == size && (size == 0 || std::memcmp(value.data(), data, size) == 0))
+			return *this;
+
+		value.assign(data, data + size);
+
+		if (!this->dirty[field])
+		{
+			this->dirty[field] = true;
+			this->dirty_fields.push_back(field);
+		}
+
+		return *this;
+	}
+
+	void Patchable_Record::assert_is_fixed(size_t field, size_t size) const
+	{
+		if (field >= this->layout.fields.size())
+			throw std::runtime_error("Record field " + std::to_string(field) + " doesn't exist");
+
+		const Record_Layout::Field &declared = this->layout.fields[field];
+
+		if (declared.is_variable)
+			throw std::runtime_error("Record field " + std::to_string(field) + " is variable-length, use set_buffer() instead");
+
+		if (declared.number_of_bytes != size)
+			throw std::runtime_error("Record field " + std::to_string(field) + " has " + std::to_string(declared.number_of_bytes) + " byte(s), but the input contains " + std::to_string(size) + " byte(s)");
+	}
+
+	void Patchable_Record::encode_all()
+	{
+		size_t total_size = 0;
+
+		for (size_t i = 0; i < this->layout.fields.size(); i++)
+		{
+			this->offsets[i] = total_size;
+
+			if (this->layout.fields[i].is_variable)
+				total_size += this->layout.fields[i].number_of_bytes;
+			total_size += this->values[i].size();
+		}
+
+		this->buffer.resize(total_size);
+
+		for (size_t i = 0; i < this->layout.fields.size(); i++)
+		{
+			const Record_Layout::Field &declared = this->layout.fields[i];
+			unsigned char *destination = this->buffer.data() + this->offsets[i];
+
+			if (declared.is_variable)
+			{
+				write_integer(destination, this->values[i].size(), declared.number_of_bytes, declared.endianness);
+				destination += declared.number_of_bytes;
+			}
+
+			if (!this->values[i].empty())
+				std::memcpy(destination, this->values[i].data(), this->values[i].size());
+		}
+
+		this->full_encode_pending = false;
+	}
+}
@@ -0,0 +1,229 @@
+#include <chrono>
+#include <stdexcept>
+
+#include "bufsd/pipeline.h"
+
+namespace bufsd
+{
+	// Idle threads first yield, then sleep briefly, so an empty queue doesn't burn a whole core
+	static void back_off(unsigned int &attempts)
+	{
+		if (++attempts < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+
+	Pipeline::Pipeline(size_t packet_count)
+		: free_packets(packet_count > 0 ? packet_count : 1)
+	{
+		// Every queue is as large as the pool, so pushing a packet can never fail
+		size_t count = this->free_packets.get_capacity();
+
+		for (size_t i = 0; i < count; i++)
+		{
+			this->packets.emplace_back(new Pipeline_Packet());
+			this->free_packets.try_push(this->packets.back().get());
+		}
+	}
+
+	Pipeline::~Pipeline()
+	{
+		this->stop();
+	}
+
+	Pipeline &Pipeline::add_stage(const Pipeline_Function &function, unsigned int worker_count)
+	{
+		if (this->started)
+			throw std::runtime_error("Can't add a stage to a started pipeline");
+
+		Stage stage;
+		stage.function = function;
+		stage.worker_count = worker_count > 0 ? worker_count : 1;
+		stage.input.reset(new Bounded_Queue<Pipeline_Packet *>(this->packets.size()));
+
+		this->stages.push_back(std::move(stage));
+
+		return *this;
+	}
+
+	Pipeline &Pipeline::set_sink(const Pipeline_Function &function)
+	{
+		if (this->started)
+			throw std::runtime_error("Can't set the sink of a started pipeline");
+
+		this->sink = function;
+
+		return *this;
+	}
+
+	void Pipeline::start()
+	{
+		if (this->started)
+			throw std::runtime_error("Pipeline is already started");
+
+		this->started = true;
+		this->sink_input.reset(new Bounded_Queue<Pipeline_Packet *>(this->packets.size()));
+
+		for (size_t stage = 0; stage < this->stages.size(); stage++)
+		{
+			for (unsigned int i = 0; i < this->stages[stage].worker_count; i++)
+				this->threads.emplace_back(&Pipeline::run_stage, this, stage);
+		}
+
+		this->threads.emplace_back(&Pipeline::run_sink, this);
+	}
+
+	Pipeline_Packet &Pipeline::acquire()
+	{
+		if (!this->started)
+			throw std::runtime_error("Pipeline is not started");
+
+		Pipeline_Packet *packet;
+		unsigned int attempts = 0;
+
+		while (!this->free_packets.try_pop(packet))
+			back_off(attempts);
+
+		packet->tag = 0;
+		packet->data.clear();
+		packet->scratch.clear();
+		packet->failed = false;
+
+		return *packet;
+	}
+
+	void Pipeline::submit(Pipeline_Packet &packet)
+	{
+		if (this->failed.load())
+		{
+			this->free_packets.try_push(&packet);
+
+			std::lock_guard<std::mutex> lock(this->error_mutex);
+			std::rethrow_exception(this->error);
+		}
+
+		packet.sequence = this->submitted++;
+
+		if (this->stages.empty())
+			this->sink_input->try_push(&packet);
+		else
+			this->stages[0].input->try_push(&packet);
+	}
+
+	void Pipeline::finish()
+	{
+		unsigned int attempts = 0;
+
+		while (this->started && this->completed.load() < this->submitted)
+			back_off(attempts);
+
+		this->stop();
+
+		if (this->failed.load())
+			std::rethrow_exception(this->error);
+	}
+
+	void Pipeline::run_stage(size_t stage)
+	{
+		Stage &current = this->stages[stage];
+		Bounded_Queue<Pipeline_Packet *> &output = stage + 1 < this->stages.size() ? *this->stages[stage + 1].input : *this->sink_input;
+		unsigned int attempts = 0;
+
+		while (true)
+		{
+			Pipeline_Packet *packet;
+
+			if (!current.input->try_pop(packet))
+			{
+				if (this->stopping.load())
+					return;
+
+				back_off(attempts);
+				continue;
+			}
+
+			attempts = 0;
+
+			if (!packet->failed)
+			{
+				try
+				{
+					current.function(*packet);
+				}
+				catch (...)
+				{
+					packet->failed = true;
+					this->record_error();
+				}
+			}
+
+			output.try_push(packet);
+		}
+	}
+
+	void Pipeline::run_sink()
+	{
+		// Packets arrive in any order; at most packets.size() are in flight, so their sequence modulo the pool size is a free slot
+		std::vector<Pipeline_Packet *> pending(this->packets.size(), nullptr);
+		unsigned long long expected = 0;
+		unsigned int attempts = 0;
+
+		while (true)
+		{
+			Pipeline_Packet *packet;
+
+			if (!this->sink_input->try_pop(packet))
+			{
+				if (this->stopping.load())
+					return;
+
+				back_off(attempts);
+				continue;
+			}
+
+			attempts = 0;
+			pending[packet->sequence % pending.size()] = packet;
+
+			while (Pipeline_Packet *next = pending[expected % pending.size()])
+			{
+				pending[expected % pending.size()] = nullptr;
+
+				if (!next->failed && this->sink)
+				{
+					try
+					{
+						this->sink(*next);
+					}
+					catch (...)
+					{
+						this->record_error();
+					}
+				}
+
+				this->free_packets.try_push(next);
+				this->completed.store(++expected);
+			}
+		}
+	}
+
+	void Pipeline::record_error()
+	{
+		std::lock_guard<std::mutex> lock(this->error_mutex);
+
+		if (!this->error)
+			this->error = std::current_exception();
+
+		this->failed.store(true);
+	}
+
+	void Pipeline::stop()
+	{
+		this->stopping.store(true);
+
+		for (std::thread &thread : this->threads)
+			thread.join();
+
+		this->threads.clear();
+	}
+}
@@ -0,0 +1,320 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bufsd/record_log.h"
+
+namespace bufsd
+{
+	static std::string make_system_error_message(const std::string &action, const std::string &path)
+	{
+		return "Could not " + action + " " + path + ": " + std::strerror(errno);
+	}
+
+	Record_Log_Reader::Record_Log_Reader(const std::string &path)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error(make_system_error_message("open record log", path));
+
+		struct stat status;
+		if (::fstat(fd, &status) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error(make_system_error_message("stat record log", path));
+		}
+
+		this->size = (size_t)status.st_size;
+
+		if (this->size > 0)
+		{
+			void *mapping = ::mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+			if (mapping == MAP_FAILED)
+			{
+				::close(fd);
+				throw std::runtime_error(make_system_error_message("map record log", path));
+			}
+
+			::madvise(mapping, this->size, MADV_SEQUENTIAL);
+			this->data = static_cast<const unsigned char *>(mapping);
+		}
+
+		::close(fd);
+	}
+
+	Record_Log_Reader::~Record_Log_Reader()
+	{
+		if (this->data)
+			::munmap(const_cast<unsigned char *>(this->data), this->size);
+	}
+
+	bool Record_Log_Reader::next(const unsigned char *&record, size_t &size)
+	{
+		if (this->torn_tail || this->cursor == this->size)
+			return false;
+
+		const unsigned char *frame = this->data + this->cursor;
+		size_t available = this->size - this->cursor;
+
+		if (available < RECORD_LOG_FRAME_HEADER_SIZE)
+		{
+			this->torn_tail = true;
+			return false;
+		}
+
+		size_t length = (size_t)read_integer(frame, 4, Endianness::BIG);
+		unsigned int checksum = (unsigned int)read_integer(frame + 4, 4, Endianness::BIG);
+
+		if (available - RECORD_LOG_FRAME_HEADER_SIZE < length ||
+			crc32c(frame + RECORD_LOG_FRAME_HEADER_SIZE, length, crc32c(frame, 4)) != checksum)
+		{
+			this->torn_tail = true;
+			return false;
+		}
+
+		record = frame + RECORD_LOG_FRAME_HEADER_SIZE;
+		size = length;
+		this->cursor += RECORD_LOG_FRAME_HEADER_SIZE + length;
+
+		return true;
+	}
+
+	void Record_Log_Reader::for_each(const std::function<void(const unsigned char *record, size_t size)> &consumer)
+	{
+		const unsigned char *record;
+		size_t size;
+
+		while (this->next(record, size))
+			consumer(record, size);
+	}
+
+	void Record_Log_Reader::reset()
+	{
+		this->cursor = 0;
+		this->torn_tail = false;
+	}
+
+	size_t Record_Log_Reader::get_valid_size() const
+	{
+		return this->cursor;
+	}
+
+	bool Record_Log_Reader::has_torn_tail() const
+	{
+		return this->torn_tail;
+	}
+
+	Record_Log_Writer::Record_Log_Writer(const std::string &path, const Group_Commit_Options &options)
+		: options(options), path(path)
+	{
+		struct stat status;
+		if (::stat(path.c_str(), &status) == 0 && status.st_size > 0)
+		{
+			Record_Log_Reader reader(path);
+			reader.for_each([](const unsigned char *, size_t) {});
+
+			if (reader.has_torn_tail() && ::truncate(path.c_str(), (off_t)reader.get_valid_size()) != 0)
+				throw std::runtime_error(make_system_error_message("truncate the torn tail of record log", path));
+		}
+
+		this->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+		if (this->fd < 0)
+			throw std::runtime_error(make_system_error_message("open record log", path));
+
+		this->committer = std::thread(&Record_Log_Writer::run_committer, this);
+	}
+
+	Record_Log_Writer::~Record_Log_Writer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+
+		this->wake_committer.notify_one();
+		this->committer.join();
+
+		::close(this->fd);
+	}
+
+	unsigned long long Record_Log_Writer::append(const unsigned char *record, size_t size)
+	{
+		if (size > 0xffffffff)
+			throw std::runtime_error("Record log records are limited to 4 GiB");
+
+		const size_t frame_size = RECORD_LOG_FRAME_HEADER_SIZE + size;
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->assert_no_error();
+
+		if (!this->pending.empty() && this->pending.size() + frame_size > this->options.max_pending_bytes)
+		{
+			// The group is as large as allowed, so it's committed right away instead of waiting for max_delay
+			this->flush_requested = true;
+			this->wake_committer.notify_one();
+
+			this->wake_appenders.wait(lock, [&]
+									  { return this->pending.empty() || this->pending.size() + frame_size <= this->options.max_pending_bytes || !this->error.empty(); });
+
+			this->assert_no_error();
+		}
+
+		bool was_empty = this->pending.empty();
+		if (was_empty)
+			this->first_pending_time = std::chrono::steady_clock::now();
+
+		size_t offset = this->pending.size();
+		this->pending.resize(offset + RECORD_LOG_FRAME_HEADER_SIZE);
+		this->pending.insert(this->pending.end(), record, record + size);
+
+		unsigned char *frame = this->pending.data() + offset;
+		write_integer(frame, size, 4, Endianness::BIG);
+		write_integer(frame + 4, crc32c(record, size, crc32c(frame, 4)), 4, Endianness::BIG);
+
+		unsigned long long sequence = ++this->appended_sequence;
+		bool group_full = this->pending.size() >= this->options.max_bytes;
+
+		lock.unlock();
+
+		if (was_empty || group_full)
+			this->wake_committer.notify_one();
+
+		return sequence;
+	}
+
+	unsigned long long Record_Log_Writer::append(const std::vector<unsigned char> &record)
+	{
+		return this->append(record.data(), record.size());
+	}
+
+	unsigned long long Record_Log_Writer::append(Serializer &serializer)
+	{
+		const std::vector<unsigned char> &buffer = serializer.get_buffer();
+
+		return this->append(buffer.data(), buffer.size());
+	}
+
+	void Record_Log_Writer::wait_durable(unsigned long long sequence)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+
+		this->wake_waiters.wait(lock, [&]
+								{ return this->durable_sequence >= sequence || !this->error.empty(); });
+
+		this->assert_no_error();
+	}
+
+	void Record_Log_Writer::commit()
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+
+		unsigned long long sequence = this->appended_sequence;
+		this->flush_requested = true;
+		this->wake_committer.notify_one();
+
+		this->wake_waiters.wait(lock, [&]
+								{ return this->durable_sequence >= sequence || !this->error.empty(); });
+
+		this->assert_no_error();
+	}
+
+	unsigned long long Record_Log_Writer::get_durable_sequence()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		return this->durable_sequence;
+	}
+
+	void Record_Log_Writer::run_committer()
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		std::vector<unsigned char> writing;
+
+		while (true)
+		{
+			if (this->pending.empty())
+			{
+				this->flush_requested = false;
+
+				if (this->stopping)
+					break;
+
+				this->wake_committer.wait(lock);
+				continue;
+			}
+
+			if (!this->stopping && !this->flush_requested && this->pending.size() < this->options.max_bytes)
+			{
+				auto deadline = this->first_pending_time + this->options.max_delay;
+
+				if (this->wake_committer.wait_until(lock, deadline) == std::cv_status::no_timeout)
+					continue;
+			}
+
+			writing.swap(this->pending);
+			unsigned long long sequence = this->appended_sequence;
+			this->flush_requested = false;
+
+			lock.unlock();
+			this->wake_appenders.notify_all();
+
+			std::string failure;
+			size_t written = 0;
+
+			while (written < writing.size())
+			{
+				ssize_t result = ::write(this->fd, writing.data() + written, writing.size() - written);
+
+				if (result < 0 && errno == EINTR)
+					continue;
+
+				if (result < 0)
+				{
+					failure = make_system_error_message("write record log", this->path);
+					break;
+				}
+
+				written += (size_t)result;
+			}
+
+#ifdef __APPLE__
+			if (failure.empty() && this->options.sync && ::fsync(this->fd) != 0)
+#else
+			if (failure.empty() && this->options.sync && ::fdatasync(this->fd) != 0)
+#endif
+				failure = make_system_error_message("sync record log", this->path);
+
+			writing.clear();
+
+			lock.lock();
+
+			if (failure.empty())
+				this->durable_sequence = sequence;
+			else if (this->error.empty())
+				this->error = failure;
+
+			this->wake_waiters.notify_all();
+
+			if (!this->error.empty())
+			{
+				this->pending.clear();
+				this->wake_appenders.notify_all();
+			}
+		}
+	}
+
+	void Record_Log_Writer::assert_no_error() const
+	{
+		if (!this->error.empty())
+			throw std::runtime_error(this->error);
+	}
+}
+
+#endif
@@ -0,0 +1,378 @@
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <memory>
+#include <random>
+#include <filesystem>
+#include <stdexcept>
+
+#include "bufsd/record_sort.h"
+
+namespace bufsd
+{
+	struct Sort_Entry
+	{
+		const unsigned char *key;
+		size_t key_size;
+		size_t offset;
+		size_t size;
+	};
+
+	static const size_t INSERTION_SORT_THRESHOLD = 32;
+
+	static void extract_key(const Record_Sort_Options &options, const unsigned char *record, size_t size, const unsigned char *&key, size_t &key_size)
+	{
+		if (options.key_offset >= size)
+		{
+			key = record + size;
+			key_size = 0;
+			return;
+		}
+
+		key = record + options.key_offset;
+		key_size = size - options.key_offset < options.key_length ? size - options.key_offset : options.key_length;
+	}
+
+	static int compare_keys(const unsigned char *a, size_t a_size, const unsigned char *b, size_t b_size, size_t depth)
+	{
+		size_t a_remaining = a_size > depth ? a_size - depth : 0;
+		size_t b_remaining = b_size > depth ? b_size - depth : 0;
+		size_t common = a_remaining < b_remaining ? a_remaining : b_remaining;
+
+		int result = common ? std::memcmp(a + depth, b + depth, common) : 0;
+		if (result != 0)
+			return result;
+
+		return a_remaining < b_remaining ? -1 : (a_remaining > b_remaining ? 1 : 0);
+	}
+
+	static size_t bucket_of(const Sort_Entry &entry, size_t depth)
+	{
+		return depth < entry.key_size ? 1 + (size_t)entry.key[depth] : 0;
+	}
+
+	static void insertion_sort(std::vector<Sort_Entry> &entries, size_t begin, size_t end, size_t depth)
+	{
+		for (size_t i = begin + 1; i < end; i++)
+		{
+			Sort_Entry entry = entries[i];
+			size_t j = i;
+
+			while (j > begin && compare_keys(entries[j - 1].key, entries[j - 1].key_size, entry.key, entry.key_size, depth) > 0)
+			{
+				entries[j] = entries[j - 1];
+				j--;
+			}
+
+			entries[j] = entry;
+		}
+	}
+
+	static void radix_sort(std::vector<Sort_Entry> &entries)
+	{
+		struct Range
+		{
+			size_t begin;
+			size_t end;
+			size_t depth;
+		};
+
+		std::vector<Sort_Entry> scratch(entries.size());
+		std::vector<Range> pending{{0, entries.size(), 0}};
+
+		while (!pending.empty())
+		{
+			Range range = pending.back();
+			pending.pop_back();
+
+			if (range.end - range.begin < INSERTION_SORT_THRESHOLD)
+			{
+				insertion_sort(entries, range.begin, range.end, range.depth);
+				continue;
+			}
+
+			size_t counts[257] = {};
+			for (size_t i = range.begin; i < range.end; i++)
+				counts[bucket_of(entries[i], range.depth)]++;
+
+			if (counts[0] == 0)
+			{
+				size_t only_bucket = bucket_of(entries[range.begin], range.depth);
+				if (counts[only_bucket] == range.end - range.begin)
+				{
+					pending.push_back({range.begin, range.end, range.depth + 1});
+					continue;
+				}
+			}
+
+			size_t starts[257];
+			size_t position = range.begin;
+			for (size_t bucket = 0; bucket < 257; bucket++)
+			{
+				starts[bucket] = position;
+				position += counts[bucket];
+			}
+
+			size_t next[257];
+			std::memcpy(next, starts, sizeof(starts));
+			for (size_t i = range.begin; i < range.end; i++)
+				scratch[next[bucket_of(entries[i], range.depth)]++] = entries[i];
+
+			std::copy(scratch.begin() + range.begin, scratch.begin() + range.end, entries.begin() + range.begin);
+
+			for (size_t bucket = 1; bucket < 257; bucket++)
+			{
+				if (counts[bucket] > 1)
+					pending.push_back({starts[bucket], starts[bucket] + counts[bucket], range.depth + 1});
+			}
+		}
+	}
+
+	static std::vector<Sort_Entry> make_sorted_entries(const std::vector<unsigned char> &records, const Record_Sort_Options &options)
+	{
+		options.prefix.validate();
+
+		const size_t prefix_size = options.prefix.number_of_bytes;
+		std::vector<Sort_Entry> entries;
+		size_t offset = 0;
+
+		while (offset < records.size())
+		{
+			if (records.size() - offset < prefix_size)
+				throw std::runtime_error("Truncated length prefix at offset " + std::to_string(offset));
+
+			size_t size = options.prefix.read(records.data() + offset);
+			if (records.size() - offset - prefix_size < size)
+				throw std::runtime_error("Truncated record at offset " + std::to_string(offset));
+
+			Sort_Entry entry;
+			entry.offset = offset;
+			entry.size = prefix_size + size;
+			extract_key(options, records.data() + offset + prefix_size, size, entry.key, entry.key_size);
+			entries.push_back(entry);
+
+			offset += prefix_size + size;
+		}
+
+		radix_sort(entries);
+
+		return entries;
+	}
+
+	std::vector<unsigned char> sort_records(const std::vector<unsigned char> &records, const Record_Sort_Options &options)
+	{
+		std::vector<unsigned char> sorted;
+		sorted.reserve(records.size());
+
+		for (const Sort_Entry &entry : make_sorted_entries(records, options))
+			sorted.insert(sorted.end(), records.begin() + entry.offset, records.begin() + entry.offset + entry.size);
+
+		return sorted;
+	}
+
+	class Run_Reader
+	{
+	public:
+		Run_Reader(const std::string &path, const Length_Prefix &prefix, size_t buffer_size)
+			: file(path, std::ios::binary), prefix(prefix), buffer(buffer_size ? buffer_size : 1)
+		{
+			if (!this->file)
+				throw std::runtime_error("Could not open sort run " + path);
+		}
+
+		Run_Reader(std::vector<unsigned char> &&records, const Length_Prefix &prefix)
+			: prefix(prefix), buffer(std::move(records)), end(buffer.size())
+		{
+		}
+
+		bool next()
+		{
+			unsigned char prefix_bytes[8];
+
+			if (!this->read(prefix_bytes, this->prefix.number_of_bytes))
+				return false;
+
+			this->record.resize(this->prefix.read(prefix_bytes));
+			if (!this->read(this->record.data(), this->record.size()))
+				throw std::runtime_error("Truncated record in sort run");
+
+			return true;
+		}
+
+		std::vector<unsigned char> record;
+
+	private:
+		bool read(unsigned char *destination, size_t size)
+		{
+			while (size > 0)
+			{
+				if (this->position == this->end && !this->refill())
+					return false;
+
+				size_t chunk = this->end - this->position < size ? this->end - this->position : size;
+				std::memcpy(destination, this->buffer.data() + this->position, chunk);
+
+				this->position += chunk;
+				destination += chunk;
+				size -= chunk;
+			}
+
+			return true;
+		}
+
+		bool refill()
+		{
+			if (!this->file.is_open())
+				return false;
+
+			this->file.read(reinterpret_cast<char *>(this->buffer.data()), this->buffer.size());
+			this->position = 0;
+			this->end = (size_t)this->file.gcount();
+
+			return this->end > 0;
+		}
+
+	private:
+		std::ifstream file;
+		Length_Prefix prefix;
+		std::vector<unsigned char> buffer;
+		size_t position = 0;
+		size_t end = 0;
+	};
+
+	External_Record_Sorter::External_Record_Sorter(const Record_Sort_Options &options, const External_Sort_Options &external_options)
+		: options(options), external_options(external_options)
+	{
+		this->options.prefix.validate();
+
+		if (this->external_options.temporary_directory.empty())
+			this->external_options.temporary_directory = std::filesystem::temp_directory_path().string();
+	}
+
+	External_Record_Sorter::~External_Record_Sorter()
+	{
+		this->remove_runs();
+	}
+
+	void External_Record_Sorter::add(const unsigned char *record, size_t size)
+	{
+		unsigned char prefix_bytes[8];
+		this->options.prefix.write(prefix_bytes, size);
+
+		this->records.insert(this->records.end(), prefix_bytes, prefix_bytes + this->options.prefix.number_of_bytes);
+		this->records.insert(this->records.end(), record, record + size);
+
+		if (this->records.size() >= this->external_options.memory_limit)
+			this->spill();
+	}
+
+	void External_Record_Sorter::add(const std::vector<unsigned char> &record)
+	{
+		this->add(record.data(), record.size());
+	}
+
+	void External_Record_Sorter::finish(const std::function<void(const unsigned char *record, size_t size)> &consumer)
+	{
+		struct Head
+		{
+			Run_Reader *reader;
+			size_t source;
+			const unsigned char *key;
+			size_t key_size;
+		};
+
+		auto greater = [](const Head &a, const Head &b)
+		{
+			int result = compare_keys(a.key, a.key_size, b.key, b.key_size, 0);
+			return result != 0 ? result > 0 : a.source > b.source;
+		};
+
+		std::vector<std::unique_ptr<Run_Reader>> readers;
+		for (const std::string &run : this->runs)
+			readers.emplace_back(new Run_Reader(run, this->options.prefix, this->external_options.merge_buffer_size));
+		readers.emplace_back(new Run_Reader(sort_records(this->records, this->options), this->options.prefix));
+
+		this->records.clear();
+		this->records.shrink_to_fit();
+
+		std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+
+		auto push_next = [&](Run_Reader *reader, size_t source)
+		{
+			if (!reader->next())
+				return;
+
+			Head head{reader, source, nullptr, 0};
+			extract_key(this->options, reader->record.data(), reader->record.size(), head.key, head.key_size);
+			heads.push(head);
+		};
+
+		for (size_t source = 0; source < readers.size(); source++)
+			push_next(readers[source].get(), source);
+
+		while (!heads.empty())
+		{
+			Head head = heads.top();
+			heads.pop();
+
+			consumer(head.reader->record.data(), head.reader->record.size());
+			push_next(head.reader, head.source);
+		}
+
+		readers.clear();
+		this->remove_runs();
+	}
+
+	void External_Record_Sorter::finish(const std::string &path)
+	{
+		std::ofstream output(path, std::ios::binary | std::ios::trunc);
+		if (!output)
+			throw std::runtime_error("Could not open sort output " + path);
+
+		unsigned char prefix_bytes[8];
+
+		this->finish([&](const unsigned char *record, size_t size)
+					 {
+						 this->options.prefix.write(prefix_bytes, size);
+						 output.write(reinterpret_cast<const char *>(prefix_bytes), this->options.prefix.number_of_bytes);
+						 output.write(reinterpret_cast<const char *>(record), size); });
+
+		if (!output.flush())
+			throw std::runtime_error("Could not write sort output " + path);
+	}
+
+	size_t External_Record_Sorter::get_run_count() const
+	{
+		return this->runs.size();
+	}
+
+	void External_Record_Sorter::spill()
+	{
+		static std::random_device random;
+
+		std::filesystem::path path = std::filesystem::path(this->external_options.temporary_directory) /
+									 ("bufsd-run-" + std::to_string(random()) + "-" + std::to_string(this->runs.size()) + ".tmp");
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		for (const Sort_Entry &entry : make_sorted_entries(this->records, this->options))
+			file.write(reinterpret_cast<const char *>(this->records.data() + entry.offset), entry.size);
+
+		if (!file.flush())
+			throw std::runtime_error("Could not write sort run " + path.string());
+
+		this->runs.push_back(path.string());
+		this->records.clear();
+	}
+
+	void External_Record_Sorter::remove_runs()
+	{
+		for (const std::string &run : this->runs)
+		{
+			std::error_code error;
+			std::filesystem::remove(run, error);
+		}
+
+		this->runs.clear();
+	}
+}
@@ -0,0 +1,429 @@
+#ifdef __linux__
+
+#include <new>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "bufsd/shm_channel.h"
+
+namespace bufsd
+{
+	static const unsigned long long CHANNEL_MAGIC = 0x4255465344534d31ULL; // "BUFSDSM1"
+	static const size_t FRAME_HEADER_SIZE = 16;
+	static const unsigned int FRAME_PADDING = 1;
+
+	// Producer and consumer fields live on separate cache lines so neither side invalidates the other's line on every frame.
+	// head and tail are the only commit points: sequence numbers are recovered from the frames between them, so a crash
+	// between two stores can never leave a sequence that disagrees with the ring
+	struct Shm_Channel_Header
+	{
+		std::atomic<unsigned long long> magic;
+		unsigned long long capacity;
+
+		alignas(64) std::atomic<unsigned long long> head;
+		std::atomic<unsigned int> data_signal;
+		std::atomic<unsigned int> consumer_waiting;
+
+		alignas(64) std::atomic<unsigned long long> tail;
+		std::atomic<unsigned long long> released_sequence;
+		std::atomic<unsigned int> space_signal;
+		std::atomic<unsigned int> producer_waiting;
+	};
+
+	static const size_t RING_OFFSET = (sizeof(Shm_Channel_Header) + 63) / 64 * 64;
+
+	static size_t align_frame(size_t size)
+	{
+		return (size + 7) & ~(size_t)7;
+	}
+
+	static bool futex_wait(std::atomic<unsigned int> *address, unsigned int expected, const struct timespec *timeout)
+	{
+		long result = ::syscall(SYS_futex, reinterpret_cast<unsigned int *>(address), FUTEX_WAIT, expected, timeout, nullptr, 0);
+
+		return !(result < 0 && errno == ETIMEDOUT);
+	}
+
+	static long long monotonic_ns()
+	{
+		struct timespec now;
+		::clock_gettime(CLOCK_MONOTONIC, &now);
+
+		return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+	}
+
+	static void futex_wake(std::atomic<unsigned int> *address)
+	{
+		::syscall(SYS_futex, reinterpret_cast<unsigned int *>(address), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+	}
+
+	// Sequence of the first (or last) frame between tail and head, or 0 if there is none
+	static unsigned long long find_frame_sequence(const unsigned char *ring, unsigned long long capacity, unsigned long long tail, unsigned long long head, bool last)
+	{
+		unsigned long long sequence = 0;
+
+		while (tail != head)
+		{
+			size_t offset = (size_t)(tail & (capacity - 1));
+
+			if (capacity - offset < FRAME_HEADER_SIZE)
+			{
+				tail += capacity - offset;
+				continue;
+			}
+
+			unsigned int frame_header[2];
+			std::memcpy(frame_header, ring + offset, sizeof(frame_header));
+
+			if (frame_header[1] == FRAME_PADDING)
+			{
+				tail += FRAME_HEADER_SIZE + frame_header[0];
+				continue;
+			}
+
+			std::memcpy(&sequence, ring + offset + sizeof(frame_header), sizeof(sequence));
+
+			if (!last)
+				break;
+
+			tail += align_frame(FRAME_HEADER_SIZE + frame_header[0]);
+		}
+
+		return sequence;
+	}
+
+	// Sequence of the last frame released by the consumer: released_sequence is stored before tail, so it's only
+	// trusted once every frame is released, otherwise it's derived from the oldest frame still in the ring
+	static unsigned long long find_released_sequence(Shm_Channel_Header *header, const unsigned char *ring)
+	{
+		unsigned long long tail = header->tail.load(std::memory_order_acquire);
+		unsigned long long head = header->head.load(std::memory_order_acquire);
+
+		if (tail == head)
+			return header->released_sequence.load(std::memory_order_relaxed);
+
+		return find_frame_sequence(ring, header->capacity, tail, head, false) - 1;
+	}
+
+	static void *map_channel(int fd, size_t size)
+	{
+		void *mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+		if (mapping == MAP_FAILED)
+		{
+			int error = errno;
+			::close(fd);
+			throw std::runtime_error(std::string("Could not map shared-memory channel: ") + std::strerror(error));
+		}
+
+		return mapping;
+	}
+
+	static size_t attach_channel(int fd, const std::string &name)
+	{
+		struct stat status;
+
+		if (::fstat(fd, &status) != 0 || (size_t)status.st_size < RING_OFFSET)
+		{
+			::close(fd);
+			throw std::runtime_error("Shared-memory object \"" + name + "\" is not a bufsd channel");
+		}
+
+		return (size_t)status.st_size;
+	}
+
+	static void check_channel(Shm_Channel_Header *header, void *mapping, size_t mapping_size, int fd, const std::string &name)
+	{
+		if (header->magic.load(std::memory_order_acquire) != CHANNEL_MAGIC || RING_OFFSET + header->capacity != mapping_size)
+		{
+			::munmap(mapping, mapping_size);
+			::close(fd);
+			throw std::runtime_error("Shared-memory object \"" + name + "\" is not a bufsd channel");
+		}
+	}
+
+	void unlink_shm_channel(const std::string &name)
+	{
+		if (::shm_unlink(name.c_str()) != 0 && errno != ENOENT)
+			throw std::runtime_error("Could not unlink shared-memory channel \"" + name + "\": " + std::strerror(errno));
+	}
+
+	Shm_Channel_Writer::Shm_Channel_Writer(const std::string &name, size_t capacity)
+	{
+		size_t ring_size = 64;
+		while (ring_size < capacity)
+			ring_size <<= 1;
+
+		this->fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+		if (this->fd >= 0)
+		{
+			this->mapping_size = RING_OFFSET + ring_size;
+
+			if (::ftruncate(this->fd, (off_t)this->mapping_size) != 0)
+			{
+				int error = errno;
+				::close(this->fd);
+				::shm_unlink(name.c_str());
+				throw std::runtime_error("Could not size shared-memory channel \"" + name + "\": " + std::strerror(error));
+			}
+
+			this->mapping = map_channel(this->fd, this->mapping_size);
+			this->header = new (this->mapping) Shm_Channel_Header();
+			this->header->capacity = ring_size;
+			this->header->magic.store(CHANNEL_MAGIC, std::memory_order_release);
+		}
+		else if (errno == EEXIST)
+		{
+			this->fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+			if (this->fd < 0)
+				throw std::runtime_error("Could not open shared-memory channel \"" + name + "\": " + std::strerror(errno));
+
+			this->mapping_size = attach_channel(this->fd, name);
+			this->mapping = map_channel(this->fd, this->mapping_size);
+			this->header = static_cast<Shm_Channel_Header *>(this->mapping);
+			check_channel(this->header, this->mapping, this->mapping_size, this->fd, name);
+		}
+		else
+		{
+			throw std::runtime_error("Could not create shared-memory channel \"" + name + "\": " + std::strerror(errno));
+		}
+
+		this->ring = static_cast<unsigned char *>(this->mapping) + RING_OFFSET;
+
+		// Only this producer adds frames, so the ones between tail and head stay intact while they are walked
+		unsigned long long tail = this->header->tail.load(std::memory_order_acquire);
+		unsigned long long head = this->header->head.load(std::memory_order_acquire);
+		this->sequence = find_frame_sequence(this->ring, this->header->capacity, tail, head, true);
+
+		if (this->sequence == 0)
+			this->sequence = find_released_sequence(this->header, this->ring);
+	}
+
+	Shm_Channel_Writer::~Shm_Channel_Writer()
+	{
+		::munmap(this->mapping, this->mapping_size);
+		::close(this->fd);
+	}
+
+	unsigned char *Shm_Channel_Writer::reserve(size_t size)
+	{
+		const unsigned long long capacity = this->header->capacity;
+		const size_t needed = align_frame(FRAME_HEADER_SIZE + size);
+
+		if (size > UINT_MAX || needed > capacity)
+			throw std::runtime_error("Frame of " + std::to_string(size) + " bytes can't fit in a channel of " + std::to_string(capacity) + " bytes");
+
+		unsigned long long head = this->header->head.load(std::memory_order_relaxed);
+		size_t offset = (size_t)(head & (capacity - 1));
+
+		// Frames are never split across the end of the ring, so they can be read in place
+		size_t padding = offset + needed > capacity ? (size_t)(capacity - offset) : 0;
+
+		while (true)
+		{
+			unsigned long long tail = this->header->tail.load(std::memory_order_acquire);
+			if (head + padding + needed - tail <= capacity)
+				break;
+
+			unsigned int signal = this->header->space_signal.load();
+			this->header->producer_waiting.store(1);
+
+			if (head + padding + needed - this->header->tail.load() > capacity)
+				futex_wait(&this->header->space_signal, signal, nullptr);
+
+			this->header->producer_waiting.store(0);
+		}
+
+		if (padding >= FRAME_HEADER_SIZE)
+		{
+			unsigned int padding_header[2] = {(unsigned int)(padding - FRAME_HEADER_SIZE), FRAME_PADDING};
+			std::memcpy(this->ring + offset, padding_header, sizeof(padding_header));
+		}
+
+		this->reserved = true;
+		this->reserved_position = head + padding;
+		this->reserved_size = size;
+
+		return this->ring + (size_t)(this->reserved_position & (capacity - 1)) + FRAME_HEADER_SIZE;
+	}
+
+	unsigned long long Shm_Channel_Writer::commit(size_t size)
+	{
+		if (!this->reserved)
+			throw std::runtime_error("Nothing reserved to commit");
+
+		if (size > this->reserved_size)
+			throw std::runtime_error("Committing " + std::to_string(size) + " bytes but only " + std::to_string(this->reserved_size) + " are reserved");
+
+		unsigned long long sequence = this->sequence + 1;
+		unsigned char *frame = this->ring + (size_t)(this->reserved_position & (this->header->capacity - 1));
+
+		unsigned int frame_header[2] = {(unsigned int)size, 0};
+		std::memcpy(frame, frame_header, sizeof(frame_header));
+		std::memcpy(frame + sizeof(frame_header), &sequence, sizeof(sequence));
+
+		this->reserved = false;
+		this->sequence = sequence;
+		this->header->head.store(this->reserved_position + align_frame(FRAME_HEADER_SIZE + size));
+
+		this->header->data_signal.fetch_add(1);
+		if (this->header->consumer_waiting.load())
+			futex_wake(&this->header->data_signal);
+
+		return sequence;
+	}
+
+	unsigned long long Shm_Channel_Writer::write(const unsigned char *data, size_t size)
+	{
+		std::memcpy(this->reserve(size), data, size);
+
+		return this->commit(size);
+	}
+
+	unsigned long long Shm_Channel_Writer::write(Serializer &serializer)
+	{
+		const std::vector<unsigned char> &buffer = serializer.get_buffer();
+
+		return this->write(buffer.data(), buffer.size());
+	}
+
+	size_t Shm_Channel_Writer::get_capacity() const
+	{
+		return (size_t)this->header->capacity;
+	}
+
+	Shm_Channel_Reader::Shm_Channel_Reader(const std::string &name)
+	{
+		this->fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+		if (this->fd < 0)
+			throw std::runtime_error("Could not open shared-memory channel \"" + name + "\": " + std::strerror(errno));
+
+		this->mapping_size = attach_channel(this->fd, name);
+		this->mapping = map_channel(this->fd, this->mapping_size);
+		this->header = static_cast<Shm_Channel_Header *>(this->mapping);
+		check_channel(this->header, this->mapping, this->mapping_size, this->fd, name);
+
+		this->ring = static_cast<unsigned char *>(this->mapping) + RING_OFFSET;
+		this->sequence = find_released_sequence(this->header, this->ring);
+	}
+
+	Shm_Channel_Reader::~Shm_Channel_Reader()
+	{
+		::munmap(this->mapping, this->mapping_size);
+		::close(this->fd);
+	}
+
+	bool Shm_Channel_Reader::try_next(Deserializer &frame)
+	{
+		this->release();
+
+		const unsigned long long capacity = this->header->capacity;
+		unsigned long long tail = this->header->tail.load(std::memory_order_relaxed);
+		unsigned long long head = this->header->head.load(std::memory_order_acquire);
+
+		while (tail != head)
+		{
+			size_t offset = (size_t)(tail & (capacity - 1));
+
+			if (capacity - offset < FRAME_HEADER_SIZE)
+			{
+				tail += capacity - offset;
+				continue;
+			}
+
+			unsigned int frame_header[2];
+			std::memcpy(frame_header, this->ring + offset, sizeof(frame_header));
+
+			if (frame_header[1] == FRAME_PADDING)
+			{
+				tail += FRAME_HEADER_SIZE + frame_header[0];
+				continue;
+			}
+
+			unsigned long long frame_sequence;
+			std::memcpy(&frame_sequence, this->ring + offset + sizeof(frame_header), sizeof(frame_sequence));
+
+			if (frame_sequence != this->sequence + 1)
+				throw std::runtime_error("Expected frame sequence " + std::to_string(this->sequence + 1) + " but got " + std::to_string(frame_sequence));
+
+			this->sequence = frame_sequence;
+			this->pending_release = tail + align_frame(FRAME_HEADER_SIZE + frame_header[0]);
+			frame = Deserializer(this->ring + offset + FRAME_HEADER_SIZE, frame_header[0]);
+
+			return true;
+		}
+
+		if (tail != this->header->tail.load(std::memory_order_relaxed))
+			this->header->tail.store(tail);
+
+		return false;
+	}
+
+	bool Shm_Channel_Reader::next(Deserializer &frame, int timeout_ms)
+	{
+		// The deadline is fixed up front, so spurious and EINTR wake-ups only wait for what is left of it
+		const long long deadline = timeout_ms < 0 ? 0 : monotonic_ns() + (long long)timeout_ms * 1000000LL;
+
+		while (!this->try_next(frame))
+		{
+			struct timespec timeout;
+
+			if (timeout_ms >= 0)
+			{
+				long long remaining = deadline - monotonic_ns();
+				if (remaining <= 0)
+					return false;
+
+				timeout.tv_sec = (time_t)(remaining / 1000000000LL);
+				timeout.tv_nsec = (long)(remaining % 1000000000LL);
+			}
+
+			unsigned int signal = this->header->data_signal.load();
+			this->header->consumer_waiting.store(1);
+
+			bool woken = true;
+			if (this->header->head.load() == this->header->tail.load())
+				woken = futex_wait(&this->header->data_signal, signal, timeout_ms < 0 ? nullptr : &timeout);
+
+			this->header->consumer_waiting.store(0);
+
+			if (!woken)
+				return this->try_next(frame);
+		}
+
+		return true;
+	}
+
+	void Shm_Channel_Reader::release()
+	{
+		if (this->pending_release == 0)
+			return;
+
+		this->header->released_sequence.store(this->sequence, std::memory_order_relaxed);
+		this->header->tail.store(this->pending_release);
+		this->pending_release = 0;
+
+		this->header->space_signal.fetch_add(1);
+		if (this->header->producer_waiting.load())
+			futex_wake(&this->header->space_signal);
+	}
+
+	unsigned long long Shm_Channel_Reader::get_sequence() const
+	{
+		return this->sequence;
+	}
+}
+
+#endif
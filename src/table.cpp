@@ -0,0 +1,351 @@
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define BUFSD_TABLE_MMAP
+#endif
+
+#include "bufsd/table.h"
+
+namespace bufsd
+{
+	static const unsigned long long TABLE_MAGIC = 0x4255465344544231; // "BUFSDTB1"
+	static const size_t TABLE_FOOTER_SIZE = 48;
+	static const size_t MAX_KEY_SIZE = 0xffff;
+
+	static int compare_bytes(const unsigned char *a, size_t a_size, const unsigned char *b, size_t b_size)
+	{
+		size_t common = a_size < b_size ? a_size : b_size;
+
+		int result = common ? std::memcmp(a, b, common) : 0;
+		if (result != 0)
+			return result;
+
+		return a_size < b_size ? -1 : (a_size > b_size ? 1 : 0);
+	}
+
+	static unsigned long long hash_key(const unsigned char *key, size_t size)
+	{
+		unsigned long long hash = 0xcbf29ce484222325ull;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= key[i];
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash ^ (hash >> 29);
+	}
+
+	static size_t bloom_bit(unsigned long long hash, size_t probe, size_t number_of_bits)
+	{
+		unsigned long long step = (hash >> 32) | 1;
+
+		return (size_t)((hash + probe * step) % number_of_bits);
+	}
+
+	Table_Builder::Table_Builder(const std::string &path, const Table_Options &options)
+		: options(options), path(path), file(path, std::ios::binary | std::ios::trunc)
+	{
+		if (!this->file)
+			throw std::runtime_error("Could not create table " + path);
+	}
+
+	void Table_Builder::add(const std::vector<unsigned char> &key, const std::vector<unsigned char> &value)
+	{
+		if (this->finished)
+			throw std::runtime_error("Table " + this->path + " was already finished");
+
+		if (key.size() > MAX_KEY_SIZE)
+			throw std::runtime_error("Table keys are limited to " + std::to_string(MAX_KEY_SIZE) + " bytes");
+
+		// Value sizes are stored on 32 bits
+		if (value.size() > 0xffffffff)
+			throw std::runtime_error("Table values are limited to 4294967295 bytes, but " + std::to_string(value.size()) + " were given");
+
+		if (this->entry_count > 0 && compare_bytes(key.data(), key.size(), this->last_key.data(), this->last_key.size()) <= 0)
+			throw std::runtime_error("Table keys must be added in strictly increasing order");
+
+		size_t shared = 0;
+
+		if (this->block.get_buffer_size() == 0)
+		{
+			this->block_first_key = key;
+		}
+		else
+		{
+			size_t limit = std::min(key.size(), this->last_key.size());
+			while (shared < limit && key[shared] == this->last_key[shared])
+				shared++;
+		}
+
+		this->block.push_16_big_endian((unsigned short)shared)
+			.push_16_big_endian((unsigned short)(key.size() - shared))
+			.push_32_big_endian((unsigned int)value.size())
+			.push_buffer(key.data() + shared, key.size() - shared)
+			.push_buffer(value);
+
+		this->last_key = key;
+		this->key_hashes.push_back(hash_key(key.data(), key.size()));
+		this->entry_count++;
+
+		if (this->block.get_buffer_size() >= this->options.block_size)
+			this->flush_block();
+	}
+
+	void Table_Builder::finish()
+	{
+		if (this->finished)
+			return;
+
+		this->flush_block();
+
+		size_t number_of_bits = std::max<size_t>(64, this->key_hashes.size() * this->options.bloom_bits_per_key);
+		unsigned char probes = (unsigned char)std::min<size_t>(30, std::max<size_t>(1, this->options.bloom_bits_per_key * 69 / 100));
+
+		std::vector<unsigned char> bits((number_of_bits + 7) / 8, 0);
+		for (unsigned long long hash : this->key_hashes)
+		{
+			for (size_t probe = 0; probe < probes; probe++)
+			{
+				size_t bit = bloom_bit(hash, probe, number_of_bits);
+				bits[bit / 8] |= 1 << (bit % 8);
+			}
+		}
+
+		Serializer bloom;
+		bloom.push_byte(probes)
+			.push_64_big_endian((unsigned long long)number_of_bits)
+			.push_buffer(bits);
+
+		const std::vector<unsigned char> &index_bytes = this->index.get_buffer();
+		const std::vector<unsigned char> &bloom_bytes = bloom.get_buffer();
+
+		unsigned long long index_offset = this->offset;
+		unsigned long long bloom_offset = index_offset + index_bytes.size();
+
+		Serializer footer;
+		footer.push_64_big_endian(index_offset)
+			.push_64_big_endian((unsigned long long)index_bytes.size())
+			.push_64_big_endian(bloom_offset)
+			.push_64_big_endian((unsigned long long)bloom_bytes.size())
+			.push_64_big_endian((unsigned long long)this->entry_count)
+			.push_64_big_endian(TABLE_MAGIC);
+
+		this->file.write(reinterpret_cast<const char *>(index_bytes.data()), index_bytes.size());
+		this->file.write(reinterpret_cast<const char *>(bloom_bytes.data()), bloom_bytes.size());
+		this->file.write(reinterpret_cast<const char *>(footer.get_buffer().data()), TABLE_FOOTER_SIZE);
+		this->file.close();
+
+		if (!this->file)
+			throw std::runtime_error("Could not write table " + this->path);
+
+		this->finished = true;
+	}
+
+	size_t Table_Builder::get_entry_count() const
+	{
+		return this->entry_count;
+	}
+
+	void Table_Builder::flush_block()
+	{
+		size_t size = this->block.get_buffer_size();
+		if (size == 0)
+			return;
+
+		this->file.write(reinterpret_cast<const char *>(this->block.get_buffer().data()), size);
+		if (!this->file)
+			throw std::runtime_error("Could not write table " + this->path);
+
+		this->index.push_16_big_endian((unsigned short)this->block_first_key.size())
+			.push_buffer(this->block_first_key)
+			.push_64_big_endian(this->offset)
+			.push_64_big_endian((unsigned long long)size);
+
+		this->offset += size;
+		this->block = Serializer();
+	}
+
+	Table_Reader::Table_Reader(const std::string &path)
+	{
+#ifdef BUFSD_TABLE_MMAP
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("Could not open table " + path);
+
+		struct stat status;
+		if (::fstat(fd, &status) != 0 || status.st_size < (off_t)TABLE_FOOTER_SIZE)
+		{
+			::close(fd);
+			throw std::runtime_error("Table " + path + " is too small to be valid");
+		}
+
+		this->size = (size_t)status.st_size;
+		void *mapping = ::mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+
+		if (mapping == MAP_FAILED)
+			throw std::runtime_error("Could not map table " + path);
+
+		this->data = static_cast<const unsigned char *>(mapping);
+#else
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			throw std::runtime_error("Could not open table " + path);
+
+		this->fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		this->data = this->fallback.data();
+		this->size = this->fallback.size();
+
+		if (this->size < TABLE_FOOTER_SIZE)
+			throw std::runtime_error("Table " + path + " is too small to be valid");
+#endif
+
+		try
+		{
+			Deserializer footer(this->data + this->size - TABLE_FOOTER_SIZE, TABLE_FOOTER_SIZE);
+			unsigned long long index_offset = footer.get_64_big_endian();
+			unsigned long long index_size = footer.get_64_big_endian();
+			unsigned long long bloom_offset = footer.get_64_big_endian();
+			unsigned long long bloom_size = footer.get_64_big_endian();
+			this->entry_count = (size_t)footer.get_64_big_endian();
+
+			size_t data_end = this->size - TABLE_FOOTER_SIZE;
+			if (footer.get_64_big_endian() != TABLE_MAGIC || index_offset > data_end || index_size > data_end - index_offset ||
+				bloom_offset > data_end || bloom_size > data_end - bloom_offset)
+				throw std::runtime_error("Table " + path + " has an invalid footer");
+
+			Deserializer index(this->data + index_offset, (size_t)index_size);
+			while (index.get_remaining() > 0)
+			{
+				Index_Entry entry;
+				entry.first_key_size = index.get_16_big_endian();
+				entry.first_key = this->data + index_offset + index.get_cursor();
+				index.skip(entry.first_key_size);
+				entry.offset = (size_t)index.get_64_big_endian();
+				entry.size = (size_t)index.get_64_big_endian();
+
+				if (entry.offset > index_offset || entry.size > index_offset - entry.offset)
+					throw std::runtime_error("Table " + path + " has an invalid index entry");
+
+				this->blocks.push_back(entry);
+			}
+
+			Deserializer bloom(this->data + bloom_offset, (size_t)bloom_size);
+			this->bloom_probes = bloom.get_byte();
+			this->bloom_bits = (size_t)bloom.get_64_big_endian();
+			this->bloom = this->data + bloom_offset + bloom.get_cursor();
+
+			if (this->bloom_bits == 0 || bloom.get_remaining() < (this->bloom_bits + 7) / 8)
+				throw std::runtime_error("Table " + path + " has an invalid bloom filter");
+		}
+		catch (...)
+		{
+#ifdef BUFSD_TABLE_MMAP
+			::munmap(const_cast<unsigned char *>(this->data), this->size);
+#endif
+			throw;
+		}
+	}
+
+	Table_Reader::~Table_Reader()
+	{
+#ifdef BUFSD_TABLE_MMAP
+		::munmap(const_cast<unsigned char *>(this->data), this->size);
+#endif
+	}
+
+	bool Table_Reader::may_contain(const std::vector<unsigned char> &key) const
+	{
+		unsigned long long hash = hash_key(key.data(), key.size());
+
+		for (size_t probe = 0; probe < this->bloom_probes; probe++)
+		{
+			size_t bit = bloom_bit(hash, probe, this->bloom_bits);
+			if ((this->bloom[bit / 8] & (1 << (bit % 8))) == 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool Table_Reader::get(const std::vector<unsigned char> &key, std::vector<unsigned char> &value) const
+	{
+		if (!this->may_contain(key))
+			return false;
+
+		auto block = std::upper_bound(this->blocks.begin(), this->blocks.end(), key, [](const std::vector<unsigned char> &target, const Index_Entry &entry)
+									  { return compare_bytes(target.data(), target.size(), entry.first_key, entry.first_key_size) < 0; });
+
+		if (block == this->blocks.begin())
+			return false;
+		--block;
+
+		bool found = false;
+
+		this->scan_block(*block, [&](const std::vector<unsigned char> &entry_key, Deserializer &deserializer, size_t value_size)
+						 {
+							 int comparison = compare_bytes(entry_key.data(), entry_key.size(), key.data(), key.size());
+
+							 if (comparison == 0)
+							 {
+								 value = deserializer.get_buffer(value_size);
+								 found = true;
+							 }
+							 else
+							 {
+								 deserializer.skip(value_size);
+							 }
+
+							 return comparison < 0; });
+
+		return found;
+	}
+
+	void Table_Reader::for_each(const std::function<void(const std::vector<unsigned char> &key, const std::vector<unsigned char> &value)> &consumer) const
+	{
+		for (const Index_Entry &block : this->blocks)
+		{
+			this->scan_block(block, [&](const std::vector<unsigned char> &key, Deserializer &deserializer, size_t value_size)
+							 {
+								 consumer(key, deserializer.get_buffer(value_size));
+								 return true; });
+		}
+	}
+
+	size_t Table_Reader::get_entry_count() const
+	{
+		return this->entry_count;
+	}
+
+	bool Table_Reader::scan_block(const Index_Entry &entry, const std::function<bool(const std::vector<unsigned char> &key, Deserializer &deserializer, size_t value_size)> &visitor) const
+	{
+		Deserializer deserializer(this->data + entry.offset, entry.size);
+		std::vector<unsigned char> key;
+
+		while (deserializer.get_remaining() > 0)
+		{
+			unsigned short shared = deserializer.get_16_big_endian();
+			unsigned short unshared = deserializer.get_16_big_endian();
+			unsigned int value_size = deserializer.get_32_big_endian();
+
+			if (shared > key.size())
+				throw std::runtime_error("Corrupted table block at offset " + std::to_string(entry.offset));
+
+			key.resize(shared);
+			std::vector<unsigned char> suffix = deserializer.get_buffer(unshared);
+			key.insert(key.end(), suffix.begin(), suffix.end());
+
+			if (!visitor(key, deserializer, value_size))
+				return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,250 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#include "bufsd/unix_socket.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace bufsd
+{
+	static const size_t MAX_IOVECS = 1024;
+
+	std::pair<int, int> make_unix_socket_pair()
+	{
+		int fds[2];
+
+		if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+			throw std::runtime_error(std::string("Could not create Unix socket pair: ") + std::strerror(errno));
+
+		return {fds[0], fds[1]};
+	}
+
+	Unix_Frame_Sender::Unix_Frame_Sender(int fd, const Length_Prefix &prefix)
+		: fd(fd), prefix(prefix)
+	{
+		this->prefix.validate();
+	}
+
+	Unix_Frame_Sender &Unix_Frame_Sender::queue(const unsigned char *data, size_t size)
+	{
+		Pending_Frame frame;
+		frame.data = data;
+		frame.size = size;
+		this->prefix.write(frame.prefix, size);
+
+		this->pending.push_back(frame);
+
+		return *this;
+	}
+
+	Unix_Frame_Sender &Unix_Frame_Sender::queue(Serializer &serializer)
+	{
+		const std::vector<unsigned char> &buffer = serializer.get_buffer();
+
+		return this->queue(buffer.data(), buffer.size());
+	}
+
+	size_t Unix_Frame_Sender::flush()
+	{
+		const size_t prefix_size = this->prefix.number_of_bytes;
+		size_t frames_sent = 0;
+		struct iovec iovecs[MAX_IOVECS];
+
+		while (this->first_pending < this->pending.size())
+		{
+			size_t count = 0;
+			size_t skip = this->sent_of_first;
+
+			for (size_t i = this->first_pending; i < this->pending.size() && count + 2 <= MAX_IOVECS; i++)
+			{
+				Pending_Frame &frame = this->pending[i];
+
+				if (skip < prefix_size)
+				{
+					iovecs[count].iov_base = frame.prefix + skip;
+					iovecs[count].iov_len = prefix_size - skip;
+					count++;
+					skip = 0;
+				}
+				else
+				{
+					skip -= prefix_size;
+				}
+
+				if (frame.size > skip)
+				{
+					iovecs[count].iov_base = const_cast<unsigned char *>(frame.data) + skip;
+					iovecs[count].iov_len = frame.size - skip;
+					count++;
+				}
+
+				skip = 0;
+			}
+
+			struct msghdr message;
+			std::memset(&message, 0, sizeof(message));
+			message.msg_iov = iovecs;
+			message.msg_iovlen = count;
+
+			ssize_t result = ::sendmsg(this->fd, &message, MSG_NOSIGNAL);
+
+			if (result < 0 && errno == EINTR)
+				continue;
+
+			if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				break;
+
+			if (result < 0)
+				throw std::runtime_error(std::string("Could not send frames: ") + std::strerror(errno));
+
+			size_t sent = (size_t)result;
+
+			while (sent > 0)
+			{
+				size_t remaining = prefix_size + this->pending[this->first_pending].size - this->sent_of_first;
+
+				if (sent < remaining)
+				{
+					this->sent_of_first += sent;
+					break;
+				}
+
+				sent -= remaining;
+				this->first_pending++;
+				this->sent_of_first = 0;
+				frames_sent++;
+			}
+		}
+
+		if (this->first_pending == this->pending.size())
+		{
+			this->pending.clear();
+			this->first_pending = 0;
+		}
+
+		return frames_sent;
+	}
+
+	size_t Unix_Frame_Sender::get_pending_count() const
+	{
+		return this->pending.size() - this->first_pending;
+	}
+
+	Unix_Frame_Receiver::Unix_Frame_Receiver(int fd, size_t capacity, const Length_Prefix &prefix, size_t max_frame_size)
+		: fd(fd), prefix(prefix), max_frame_size(max_frame_size), ring(capacity > 16 ? capacity : 16)
+	{
+		this->prefix.validate();
+	}
+
+	size_t Unix_Frame_Receiver::receive()
+	{
+		if (this->head > 0)
+		{
+			std::memmove(this->ring.data(), this->ring.data() + this->head, this->tail - this->head);
+			this->tail -= this->head;
+			this->head = 0;
+		}
+
+		size_t buffered = this->tail;
+		if (buffered >= this->prefix.number_of_bytes)
+		{
+			size_t needed = this->prefix.number_of_bytes + this->read_frame_size(this->ring.data());
+			if (needed > this->ring.size())
+				this->ring.resize(needed);
+		}
+
+		if (this->tail == this->ring.size())
+			this->ring.resize(this->ring.size() * 2);
+
+		struct iovec iovec;
+		iovec.iov_base = this->ring.data() + this->tail;
+		iovec.iov_len = this->ring.size() - this->tail;
+
+		struct msghdr message;
+		std::memset(&message, 0, sizeof(message));
+		message.msg_iov = &iovec;
+		message.msg_iovlen = 1;
+
+		while (true)
+		{
+			ssize_t result = ::recvmsg(this->fd, &message, 0);
+
+			if (result < 0 && errno == EINTR)
+				continue;
+
+			if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				return 0;
+
+			if (result < 0)
+				throw std::runtime_error(std::string("Could not receive frames: ") + std::strerror(errno));
+
+			if (result == 0)
+				this->closed = true;
+
+			this->tail += (size_t)result;
+			return (size_t)result;
+		}
+	}
+
+	bool Unix_Frame_Receiver::next(Deserializer &frame)
+	{
+		const size_t prefix_size = this->prefix.number_of_bytes;
+		size_t buffered = this->tail - this->head;
+
+		if (buffered < prefix_size)
+			return false;
+
+		size_t size = this->read_frame_size(this->ring.data() + this->head);
+		if (buffered - prefix_size < size)
+			return false;
+
+		frame = Deserializer(this->ring.data() + this->head + prefix_size, size);
+		this->head += prefix_size + size;
+
+		return true;
+	}
+
+	size_t Unix_Frame_Receiver::poll(const std::function<void(Deserializer &frame)> &handler)
+	{
+		this->receive();
+
+		size_t handled = 0;
+		Deserializer frame(nullptr, 0);
+
+		while (this->next(frame))
+		{
+			handler(frame);
+			handled++;
+		}
+
+		return handled;
+	}
+
+	bool Unix_Frame_Receiver::is_closed() const
+	{
+		return this->closed;
+	}
+
+	size_t Unix_Frame_Receiver::read_frame_size(const unsigned char *source) const
+	{
+		size_t size = this->prefix.read(source);
+
+		// The prefix comes from the peer, so it is checked before the buffer grows to hold the frame
+		if (size > this->max_frame_size)
+			throw std::runtime_error("Received a frame of " + std::to_string(size) + " byte(s), larger than the maximum of " + std::to_string(this->max_frame_size) + " byte(s)");
+
+		return size;
+	}
+}
+
+#endif
@@ -42,4 +42,33 @@ std::vector<unsigned char> bufsd::hex_string_to_byte_vector(const std::string &h
     }
 
     return bytes;
-}
\ No newline at end of file
+}
+
+static const unsigned int *make_crc32c_table()
+{
+    static unsigned int table[256];
+
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        unsigned int crc = i;
+
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0x82f63b78 & (0u - (crc & 1)));
+
+        table[i] = crc;
+    }
+
+    return table;
+}
+
+unsigned int bufsd::crc32c(const unsigned char *data, size_t size, unsigned int crc)
+{
+    static const unsigned int *table = make_crc32c_table();
+
+    crc = ~crc;
+
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+    return ~crc;
+}